@@ -0,0 +1,89 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \brief IOCallback writing a file without going through the system cache
+*/
+#ifndef LIBEBML_DIRECTWRITEIOCALLBACK_H
+#define LIBEBML_DIRECTWRITEIOCALLBACK_H
+
+#include "IOCallback.h"
+
+#include <memory>
+
+namespace libebml {
+
+/*!
+  \class DirectWriteIOCallback
+  \brief create a file written with direct I/O, bypassing the system cache
+
+  The sequential writes are accumulated in an aligned buffer written when it's
+  full, so the file is always written in aligned blocks. Rewriting data still
+  in the buffer, as done by EbmlElement::OverwriteHead(), patches the buffer.
+  Rewriting data already written reads and writes back the aligned blocks
+  containing them. The unaligned end of the file is written padded and the
+  file is truncated to its actual size by Flush() and close().
+
+  The file is opened with O_DIRECT, or F_NOCACHE on macOS. If the filesystem
+  doesn't support it the file is written with regular I/O, see IsDirect().
+  \note only available on POSIX systems
+*/
+class EBML_DLL_API DirectWriteIOCallback : public IOCallback {
+public:
+  /// alignment of the direct writes, in memory and in the file
+  static constexpr std::size_t Alignment = 4096;
+  static constexpr std::size_t DefaultBufferSize = 1024 * 1024;
+
+  /*!
+    \brief create or truncate the file at \a Path
+    \param BufferSize size of the sequential writes, rounded up to Alignment
+    \throw std::ios_base::failure if the file can't be created
+  */
+  explicit DirectWriteIOCallback(const char *Path, std::size_t BufferSize = DefaultBufferSize);
+  ~DirectWriteIOCallback() override;
+  DirectWriteIOCallback(const DirectWriteIOCallback&) = delete;
+  DirectWriteIOCallback& operator=(const DirectWriteIOCallback&) = delete;
+
+  std::size_t read(void *Buffer, std::size_t Size) override;
+  void setFilePointer(std::int64_t Offset, seek_mode Mode = seek_beginning) override;
+  std::size_t write(const void *Buffer, std::size_t Size) override;
+  std::uint64_t getFilePointer() override { return mPosition; }
+  void close() override;
+
+  /// write the buffered data, the file has its actual size afterwards
+  void Flush();
+
+  /// whether the file bypasses the system cache
+  bool IsDirect() const { return mDirect; }
+
+private:
+  struct AlignedFree {
+    void operator()(binary *Buffer) const;
+  };
+  using AlignedBuffer = std::unique_ptr<binary, AlignedFree>;
+  static AlignedBuffer AllocAligned(std::size_t Size);
+
+  void WriteBlocks(const binary *Buffer, std::size_t Size, std::uint64_t Position);
+  void ReadBlocks(binary *Buffer, std::size_t Size, std::uint64_t Position);
+  /// write the full buffer and start the next one
+  void WriteBuffer();
+  /// write data before the buffer, through the aligned blocks containing them
+  void PatchWritten(std::uint64_t Position, const binary *Data, std::size_t Size);
+  /// read data before the buffer, through the aligned blocks containing them
+  void ReadWritten(std::uint64_t Position, binary *Data, std::size_t Size);
+  std::uint64_t GetSize() const { return mBufferStart + mBufferUsed; }
+
+  int mFile{-1};
+  bool mDirect{false};
+  const std::size_t mBufferSize;
+  AlignedBuffer mBuffer;
+  AlignedBuffer mBlocks; ///< blocks read back to patch or read written data
+  std::uint64_t mBufferStart{0}; ///< file position of the buffer, everything before is written
+  std::size_t mBufferUsed{0};
+  std::uint64_t mPosition{0};
+};
+
+} // namespace libebml
+
+#endif // LIBEBML_DIRECTWRITEIOCALLBACK_H
@@ -11,6 +11,8 @@
 
 #include <cstdlib>
 #include <cstring>
+#include <functional>
+#include <memory>
 
 #include "EbmlTypes.h"
 #include "EbmlElement.h"
@@ -27,7 +29,9 @@ class EBML_DLL_API EbmlBinary : public EbmlElement {
   public:
     EbmlBinary(const EbmlCallbacks &);
     EbmlBinary(const EbmlBinary & ElementToClone);
+    EbmlBinary(EbmlBinary && ElementToMove) noexcept;
     EbmlBinary& operator=(const EbmlBinary & ElementToClone);
+    EbmlBinary& operator=(EbmlBinary && ElementToMove) noexcept;
     ~EbmlBinary() override;
 
     bool SizeIsValid(std::uint64_t size) const override {return size < 0x7FFFFFFF;} // we don't mind about what's inside
@@ -36,19 +40,78 @@ class EBML_DLL_API EbmlBinary : public EbmlElement {
     filepos_t ReadData(IOCallback & input, ScopeMode ReadFully = SCOPE_ALL_DATA) override;
     filepos_t UpdateSize(const ShouldWrite & writeFilter = WriteSkipDefault, bool bForceRender = false) override;
 
+    /*!
+      \brief use a malloc()'ed buffer as the payload, the element takes ownership of it
+      \note the payloads read or copied in the element may be stored in the element itself,
+      only the buffers given here are allocated by the caller
+    */
     void SetBuffer(const binary *Buffer, const std::uint32_t BufferSize) {
+      ResetSources();
       Data = const_cast<binary *>(Buffer);
       SetSize_(BufferSize);
       SetValueIsSet();
     }
 
-    binary *GetBuffer() const {return Data;}
+    /*!
+      \brief the payload of the element
+      \note a deferred payload is read from its source on the first call, once even if several
+      threads call it, the source must not be used by other threads at the same time
+      \warning payloads up to InlineSize octets are stored in the element: the buffer must not
+      be freed by the caller and is not valid after the element is moved or destroyed
+    */
+    binary *GetBuffer() const;
+
+    /*!
+      \brief copy the payload in \a Buffer of GetSize() octets
+      \note with SCOPE_DEFERRED_DATA the payload is read from the source stream
+      but not kept in the element
+    */
+    void ReadBuffer(binary *Buffer) const;
+
+    /*!
+      \brief callback receiving the payload in consecutive chunks
+    */
+    using DataSink = std::function<void(const binary *Chunk, std::size_t Size)>;
+    /*!
+      \brief callback filling \a Buffer with up to \a Size octets of the payload starting at \a Offset
+      \return the number of octets written in \a Buffer, 0 if no more data are available
+    */
+    using DataSource = std::function<std::size_t(std::uint64_t Offset, binary *Buffer, std::size_t Size)>;
+
+    /// size of the chunks used to stream payloads that are not in memory
+    static constexpr std::size_t DefaultChunkSize = 64 * 1024;
+
+    /*!
+      \brief give the payload to \a Sink in chunks of up to \a ChunkSize octets
+      \note a payload that is not loaded yet is read from its source without being kept,
+      so the memory used doesn't depend on the payload size
+    */
+    void ReadChunks(const DataSink & Sink, std::size_t ChunkSize = DefaultChunkSize) const;
+
+    /*!
+      \brief use \a Size octets produced by \a Source as the payload
+      \note the payload is requested each time it's used, in chunks of DefaultChunkSize octets
+      when rendering, and is only kept in memory if GetBuffer() is called
+    */
+    void SetSource(std::uint64_t Size, DataSource Source);
+    /*!
+      \brief use \a Size octets of \a Input at \a Position as the payload
+      \note the caller keeps \a Input valid as long as the element is used,
+      rendering the element uses IOCallback::CopyFrom()
+    */
+    void SetSource(IOCallback & Input, std::uint64_t Position, std::uint64_t Size);
+
+    /// whether the payload is read from a source when it's accessed and is not loaded yet
+    bool IsDeferred() const;
+    /// position of the payload in the source stream when it's not loaded yet
+    std::uint64_t GetDeferredPosition() const;
 
     void CopyBuffer(const binary *Buffer, const std::uint32_t BufferSize) {
+      FreeData();
+      ResetSources();
+      Data = AllocData(BufferSize);
       if (Data != nullptr)
-        free(Data);
-      Data = static_cast<binary *>(malloc(BufferSize * sizeof(binary)));
-      memcpy(Data, Buffer, BufferSize);
+        memcpy(Data, Buffer, BufferSize);
       SetSize_(BufferSize);
       SetValueIsSet();
     }
@@ -62,8 +125,43 @@ class EBML_DLL_API EbmlBinary : public EbmlElement {
 
     bool operator==(const EbmlBinary & ElementToCompare) const;
 
+    void AddMemoryUsage(EbmlMemoryReport & Report) const override {
+      Report.Add(*this, ObjectSize(), AllocatedSize());
+    }
+
+    /*!
+      \brief payloads up to this size are stored in the element, without allocation
+      \note 16 octets fit the payload pointer and the deferred source in 4 aligned pointers,
+      with 23 octets every binary element would be 8 octets larger because of the padding
+    */
+    static constexpr std::size_t InlineSize = 16;
+
+  protected:
+    /// octets allocated outside of the element for the payload
+    std::size_t AllocatedSize() const {
+      if (IsDeferred())
+        return 0;
+      return Data != nullptr && Data != InlineData ? static_cast<std::size_t>(GetSize()) : 0;
+    }
+
   private:
-    binary *Data{nullptr}; // the binary data inside the element
+    mutable binary *Data{nullptr}; // the binary data inside the element, set once when a deferred payload is loaded
+    mutable binary InlineData[InlineSize];
+    /// where the payload is read from when it's not loaded yet, kept out of the element
+    struct DeferredPayload;
+    std::unique_ptr<DeferredPayload> Deferred;
+
+    void LoadDeferred() const;
+    void ReadDeferred(binary *Buffer) const;
+    void ReadDeferred(binary *Buffer, std::uint64_t Offset, std::size_t Size) const;
+    void ResetSources();
+
+    binary *AllocData(std::uint64_t DataSize) const;
+    void FreeData() {
+      if (Data != InlineData)
+        free(Data);
+      Data = nullptr;
+    }
 };
 
 } // namespace libebml
@@ -39,6 +39,10 @@ DECLARE_EBML_BINARY_LENGTH(EbmlCrc32, 4)
       Use this with Update() to Finalize() or Complete the CRC32
     */
     void Finalize();
+    /*!
+      Discard the data given to Update() since the last Finalize()
+    */
+    void ResetCRC();
     /*!
       Returns a std::uint32_t that has the value of the CRC32
     */
@@ -49,7 +53,6 @@ DECLARE_EBML_BINARY_LENGTH(EbmlCrc32, 4)
     void ForceCrc32(std::uint32_t NewValue) { m_crc_final = NewValue; SetValueIsSet();}
 
     private:
-    void ResetCRC();
     void UpdateByte(binary b);
 
     std::uint32_t m_crc;
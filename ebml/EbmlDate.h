@@ -59,12 +59,13 @@ class EBML_DLL_API EbmlDate : public EbmlElementDefaultSameStorage<std::int64_t>
 
     filepos_t ReadData(IOCallback & input, ScopeMode ReadFully = SCOPE_ALL_DATA) override;
 
-  protected:
+    /// convert a UNIX/C/EPOCH date to the nanoseconds since 2001/01/01 stored in EBML
     static std::int64_t EpochToEbml(std::int64_t epoch)
     {
       return (epoch - UnixEpochDelay) * 1'000'000'000;
     }
 
+    /// convert the nanoseconds since 2001/01/01 stored in EBML to a UNIX/C/EPOCH date
     static std::int64_t EbmlToEpoch(std::int64_t ebml)
     {
       return ebml/1'000'000'000 + UnixEpochDelay;
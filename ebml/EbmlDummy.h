@@ -20,11 +20,13 @@ class EBML_DLL_API EbmlDummy : public EbmlBinary {
     bool IsDummy() const override {return true;}
     bool IsDefaultValue() const override {return true;}
 
+
     EbmlId const &GetClassId() const override {
       return DummyId;
     }
 
     EbmlElement * Clone() const override { return new EbmlDummy(DummyId); }
+    std::size_t ObjectSize() const override { return sizeof(EbmlDummy); }
 
     static EbmlElement & Create() { return *(new EbmlDummy()); }
 
@@ -10,11 +10,16 @@
 
 #include "EbmlTypes.h"
 #include "EbmlId.h"
+#include "EbmlMemoryReport.h"
 #include "IOCallback.h"
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <limits>
 #include <cstddef>
 
@@ -248,6 +253,7 @@ class DllApi x : public BaseClass { \
 #define EBML_CONCRETE_CLASS(Type) \
     public: \
         libebml::EbmlElement * Clone() const override { return new Type(*this); } \
+        std::size_t ObjectSize() const override { return sizeof(Type); } \
     static libebml::EbmlElement & Create() {return *(new Type);} \
         static constexpr const libebml::EbmlCallbacks & ClassInfo() {return ClassInfos;} \
 
@@ -549,9 +555,59 @@ class EBML_DLL_API EbmlCallbacksMaster : public EbmlCallbacks {
 */
 class EBML_DLL_API EbmlElement {
   public:
-    // callback to tell if the element should be written or not
-    // \return true if the element should be written
-    using ShouldWrite = std::function<bool(const EbmlElement &)>;
+    /*!
+      \brief callback to tell if the element should be written or not
+      \note WriteAll, WriteSkipDefault and plain functions are called directly,
+      std::function is only used for other callables
+    */
+    class ShouldWrite {
+      public:
+        using Function = bool (*)(const EbmlElement &);
+
+        /// \throws std::invalid_argument if \a Filter is nullptr
+        ShouldWrite(Function Filter)
+          :Mode(Filter == &WriteAll ? FilterAll : Filter == &WriteSkipDefault ? FilterSkipDefault : FilterFunction)
+          ,Plain(Filter)
+        {
+          if (Filter == nullptr)
+            throw std::invalid_argument("missing element filter");
+        }
+
+        /// lambdas without captures are called as plain functions
+        template<typename Callable, std::enable_if_t<
+          std::is_convertible_v<Callable, Function> && !std::is_same_v<std::decay_t<Callable>, Function>, int> = 0>
+        ShouldWrite(Callable && Filter)
+          :ShouldWrite(static_cast<Function>(Filter))
+        {}
+
+        template<typename Callable, std::enable_if_t<
+          !std::is_convertible_v<Callable, Function> && !std::is_same_v<std::decay_t<Callable>, ShouldWrite>, int> = 0>
+        ShouldWrite(Callable && Filter)
+          :Mode(FilterCallable)
+          ,Custom(std::forward<Callable>(Filter))
+        {}
+
+        /// \return true if the element should be written
+        bool operator()(const EbmlElement & elt) const {
+          switch (Mode) {
+            case FilterAll:         return WriteAll(elt);
+            case FilterSkipDefault: return WriteSkipDefault(elt);
+            case FilterFunction:    return Plain(elt);
+            default:                return Custom(elt);
+          }
+        }
+
+      private:
+        enum FilterMode : std::uint8_t {
+          FilterAll,
+          FilterSkipDefault,
+          FilterFunction,
+          FilterCallable,
+        };
+        FilterMode Mode;
+        Function Plain{nullptr};
+        std::function<bool(const EbmlElement &)> Custom;
+    };
 
     // write only elements that don't have their default value set
     static bool WriteSkipDefault(const EbmlElement &elt) {
@@ -572,8 +628,10 @@ class EBML_DLL_API EbmlElement {
     virtual const EbmlCallbacks & ElementSpec() const { return ClassInfo; }
 
     /// Set the minimum length that will be used to write the element size (-1 = optimal)
-    void SetSizeLength(unsigned int NewSizeLength) {SizeLength = NewSizeLength;}
-    unsigned int GetSizeLength() const {return SizeLength;}
+    void SetSizeLength(unsigned int NewSizeLength) {
+      Flags = static_cast<std::uint8_t>((Flags & ~SizeLengthMask) | std::min<unsigned int>(NewSizeLength, SizeLengthMask));
+    }
+    unsigned int GetSizeLength() const {return Flags & SizeLengthMask;}
 
     static EbmlElement * FindNextElement(IOCallback & DataStream, const EbmlSemanticContext & Context, int & UpperLevel, std::uint64_t MaxDataSize, bool AllowDummyElt, unsigned int MaxLowerLevel = 1);
     static EbmlElement * FindNextID(IOCallback & DataStream, const EbmlCallbacks & ClassInfos, std::uint64_t MaxDataSize);
@@ -605,7 +663,7 @@ class EBML_DLL_API EbmlElement {
     bool SetSizeInfinite(bool bIsInfinite = true) {
         if (ClassInfo.CanHaveInfiniteSize())
         {
-          bSizeIsFinite = !bIsInfinite;
+          SetFlag(FlagSizeIsFinite, !bIsInfinite);
           return true;
         }
         return false;
@@ -641,6 +699,16 @@ class EBML_DLL_API EbmlElement {
     virtual bool IsDummy() const {return false;}
     virtual bool IsMaster() const {return false;}
 
+    /*!
+      \brief add the memory used by this element and its children to \a Report
+      \note classes with allocations should override it
+    */
+    virtual void AddMemoryUsage(EbmlMemoryReport & Report) const;
+    /// size of the element object, given by EBML_CONCRETE_CLASS for the final classes
+    virtual std::size_t ObjectSize() const { return sizeof(EbmlElement); }
+    /// memory used by this element and its children
+    EbmlMemoryReport GetMemoryReport() const;
+
     /*!
       \brief Force the size of an element
       \warning only possible if the size is "undefined"
@@ -656,18 +724,18 @@ class EBML_DLL_API EbmlElement {
     std::uint64_t VoidMe(IOCallback & output, const ShouldWrite& writeFilter = WriteSkipDefault) const;
 
     virtual bool IsDefaultValue() const = 0;
-    bool IsFiniteSize() const {return bSizeIsFinite;}
+    bool IsFiniteSize() const {return HasFlag(FlagSizeIsFinite);}
 
     /*!
       \brief set the default size of an element
     */
     virtual void SetDefaultSize(std::uint64_t aDefaultSize) {DefaultSize = aDefaultSize;}
 
-    bool ValueIsSet() const {return bValueIsSet;}
+    bool ValueIsSet() const {return HasFlag(FlagValueIsSet);}
 
     inline std::uint64_t GetEndPosition() const {
-      assert(bSizeIsFinite); // we don't know where the end is
-      return SizePosition + CodedSizeLength(Size, SizeLength, bSizeIsFinite) + Size;
+      assert(IsFiniteSize()); // we don't know where the end is
+      return GetSizePosition() + CodedSizeLength(Size, GetSizeLength(), IsFiniteSize()) + Size;
     }
 
     virtual bool CanWrite(const ShouldWrite & writeFilter) const {
@@ -696,26 +764,39 @@ class EBML_DLL_API EbmlElement {
     */
     EbmlElement(const EbmlElement & ElementToClone) = default;
 
+    /*!
+      \brief take the state of another element of the same class
+    */
+    EbmlElement(EbmlElement && ElementToMove) noexcept = default;
+    EbmlElement& operator=(EbmlElement && ElementToMove) noexcept;
+
         inline std::uint64_t GetDefaultSize() const {return DefaultSize;}
         inline void SetSize_(std::uint64_t aSize) {Size = aSize;}
-        inline void SetValueIsSet(bool Set = true) {bValueIsSet = Set;}
-        inline std::uint64_t GetSizePosition() const {return SizePosition;}
+        inline void SetValueIsSet(bool Set = true) {SetFlag(FlagValueIsSet, Set);}
+        /// the size is always written right after the ID
+        inline std::uint64_t GetSizePosition() const {return ElementPosition + EBML_ID_LENGTH(static_cast<const EbmlId&>(*this));}
 
   protected:
     const EbmlCallbacks & ClassInfo;
 
   private:
     std::size_t HeadSize() const {
-      return EBML_ID_LENGTH(static_cast<const EbmlId&>(*this)) + CodedSizeLength(Size, SizeLength, bSizeIsFinite);
+      return EBML_ID_LENGTH(static_cast<const EbmlId&>(*this)) + CodedSizeLength(Size, GetSizeLength(), IsFiniteSize());
     } /// return the size of the head, on reading/writing
 
+    static constexpr std::uint8_t SizeLengthMask   = 0x0F; ///< the minimum size on which the size will be written (0 = optimal)
+    static constexpr std::uint8_t FlagSizeIsFinite = 0x10;
+    static constexpr std::uint8_t FlagValueIsSet   = 0x20;
+
+    bool HasFlag(std::uint8_t Flag) const {return (Flags & Flag) != 0;}
+    void SetFlag(std::uint8_t Flag, bool Set) {
+      Flags = static_cast<std::uint8_t>(Set ? (Flags | Flag) : (Flags & ~Flag));
+    }
+
     std::uint64_t Size;        ///< the size of the data to write
     std::uint64_t DefaultSize; ///< Minimum data size to fill on rendering (0 = optimal)
-    unsigned int SizeLength{0}; /// the minimum size on which the size will be written (0 = optimal)
-    bool bSizeIsFinite{true};
     std::uint64_t ElementPosition{0};
-    std::uint64_t SizePosition{0};
-    bool bValueIsSet;
+    std::uint8_t  Flags;       ///< size length and state bits, packed in one octet
 };
 
 /*!
@@ -774,6 +855,11 @@ class EBML_DLL_API EbmlElementDefaultSameStorage : public EbmlElementDefault<T>
       return this->Value < static_cast<const EbmlElementDefaultSameStorage<T> *>(Cmp)->Value;
     }
 
+    void AddMemoryUsage(EbmlMemoryReport & Report) const override
+    {
+      Report.Add(*this, this->ObjectSize(), 0);
+    }
+
     explicit operator T() const { return Value; }
 
   private:
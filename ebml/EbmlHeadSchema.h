@@ -0,0 +1,43 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \brief decode the EBML header into a plain structure
+*/
+#ifndef LIBEBML_HEADSCHEMA_H
+#define LIBEBML_HEADSCHEMA_H
+
+#include "EbmlHead.h"
+#include "EbmlSchema.h"
+
+namespace libebml {
+
+/*!
+  \brief values of an EBML header, decoded with EbmlHeadSchema
+*/
+struct EbmlHeadValues {
+  std::uint64_t Version;
+  std::uint64_t ReadVersion;
+  std::uint64_t MaxIdLength;
+  std::uint64_t MaxSizeLength;
+  std::string   DocType;
+  std::uint64_t DocTypeVersion;
+  std::uint64_t DocTypeReadVersion;
+};
+
+/*!
+  \brief decode an EbmlHead without creating its children
+*/
+using EbmlHeadSchema = EbmlSchema<EbmlHead, EbmlHeadValues,
+  EbmlSchemaField<&EbmlHeadValues::Version,            EVersion>,
+  EbmlSchemaField<&EbmlHeadValues::ReadVersion,        EReadVersion>,
+  EbmlSchemaField<&EbmlHeadValues::MaxIdLength,        EMaxIdLength>,
+  EbmlSchemaField<&EbmlHeadValues::MaxSizeLength,      EMaxSizeLength>,
+  EbmlSchemaField<&EbmlHeadValues::DocType,            EDocType>,
+  EbmlSchemaField<&EbmlHeadValues::DocTypeVersion,     EDocTypeVersion>,
+  EbmlSchemaField<&EbmlHeadValues::DocTypeReadVersion, EDocTypeReadVersion>>;
+
+} // namespace libebml
+
+#endif // LIBEBML_HEADSCHEMA_H
@@ -8,7 +8,9 @@
 #ifndef LIBEBML_ID_H
 #define LIBEBML_ID_H
 
+#include <array>
 #include <cstddef>
+#include <cstring>
 #include "EbmlConfig.h"
 #include "EbmlTypes.h"
 
@@ -24,25 +26,46 @@ namespace libebml {
 class EBML_DLL_API EbmlId {
   public:
     constexpr EbmlId(const std::uint32_t aValue)
-      :Value(aValue), Length(LengthFromValue(aValue)) {}
+      :Value(aValue), Length(LengthFromValue(aValue))
+      ,Encoded(EncodeValue(aValue, LengthFromValue(aValue)))
+      ,HeadMask(MaskFromLength(LengthFromValue(aValue)))
+      ,HeadValue(aValue << (8 * (4 - LengthFromValue(aValue))))
+    {}
 
-    inline bool operator==(const EbmlId & TestId) const
+    inline constexpr bool operator==(const EbmlId & TestId) const
     {
-      return ((TestId.Length == Length) && (TestId.Value == Value));
+      // the length is fully defined by the value
+      return TestId.Value == Value;
     }
-    inline bool operator!=(const EbmlId & TestId) const
+    inline constexpr bool operator!=(const EbmlId & TestId) const
     {
       return !(*this == TestId);
     }
 
     inline void Fill(binary * Buffer) const {
-      for (size_t i = 0; i<Length; i++) {
-        Buffer[i] = (Value >> (8*(Length-i-1))) & 0xFF;
-      }
+      std::memcpy(Buffer, Encoded.data(), Length);
+    }
+
+    /*!
+      \brief write the encoded ID in a single 4 octets store
+      \note Buffer must have room for 4 octets, the octets after GetLength() are set to 0
+    */
+    inline void FillFixed(binary * Buffer) const {
+      std::memcpy(Buffer, Encoded.data(), Encoded.size());
+    }
+
+    /*!
+      \brief check if the ID encoded at the start of Buffer matches this one
+      \note Buffer must have 4 readable octets, only the first GetLength() ones are compared
+    */
+    inline bool Matches(const binary Buffer[4]) const {
+      return (LoadBig32(Buffer) & HeadMask) == HeadValue;
     }
 
     constexpr std::size_t GetLength() const { return Length; }
     constexpr std::uint32_t GetValue() const { return Value; }
+    /// the big-endian octets of the ID, padded with 0 up to 4 octets
+    constexpr const std::array<binary, 4> & GetEncoded() const { return Encoded; }
 
     static constexpr bool IsValid(std::uint32_t Value)
     {
@@ -65,9 +88,21 @@ class EBML_DLL_API EbmlId {
       return Value;
     }
 
+    /*!
+      \brief read an ID of aLength octets with a single 4 octets load
+      \note aValue must have 4 readable octets
+    */
+    static std::uint32_t FromEncoded(const binary aValue[4], const std::size_t aLength)
+    {
+      return LoadBig32(aValue) >> (8 * (4 - aLength));
+    }
+
   private:
     std::uint32_t Value;
     std::size_t Length;
+    std::array<binary, 4> Encoded;
+    std::uint32_t HeadMask;  ///< mask of the octets used by the ID in a 4 octets big-endian load
+    std::uint32_t HeadValue; ///< the ID in a 4 octets big-endian load
 
     static constexpr unsigned int LengthFromValue(std::uint32_t Value) {
       if (Value < 0x100)
@@ -78,6 +113,22 @@ class EBML_DLL_API EbmlId {
         return 3;
       return 4;
     }
+
+    static constexpr std::array<binary, 4> EncodeValue(std::uint32_t Value, unsigned int Length) {
+      std::array<binary, 4> Result{};
+      for (unsigned int i = 0; i<Length; i++)
+        Result[i] = static_cast<binary>((Value >> (8*(Length-i-1))) & 0xFF);
+      return Result;
+    }
+
+    static constexpr std::uint32_t MaskFromLength(unsigned int Length) {
+      return static_cast<std::uint32_t>(0xFFFFFFFFULL << (8 * (4 - Length)));
+    }
+
+    static inline std::uint32_t LoadBig32(const binary Buffer[4]) {
+      return (static_cast<std::uint32_t>(Buffer[0]) << 24) | (static_cast<std::uint32_t>(Buffer[1]) << 16) |
+             (static_cast<std::uint32_t>(Buffer[2]) << 8)  |  static_cast<std::uint32_t>(Buffer[3]);
+    }
 };
 
 } // namespace libebml
@@ -0,0 +1,152 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \brief index of the element positions in a file, saved in a sidecar file
+*/
+#ifndef LIBEBML_INDEX_H
+#define LIBEBML_INDEX_H
+
+#include "EbmlElement.h"
+#include "IOCallback.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace libebml {
+
+/*!
+  \brief position of an element in a file
+*/
+struct EBML_DLL_API EbmlIndexEntry {
+  std::uint64_t Position;  ///< position of the element ID in the file
+  std::uint64_t DataSize;  ///< size of the data, not valid when the size is unknown
+  std::uint32_t Id;        ///< value of the element EbmlId
+  std::uint32_t Parent;   ///< index of the parent entry, EbmlIndex::NoParent for top level elements
+  std::uint8_t  Depth;     ///< 0 for top level elements
+  std::uint8_t  HeadSize;  ///< size of the ID and the coded size
+  bool          SizeIsFinite;
+
+  std::uint64_t GetDataStart() const { return Position + HeadSize; }
+};
+
+/*!
+  \class EbmlIndex
+  \brief elements found in a file up to a given depth, to reopen it without scanning it again
+
+  The index is saved in a versioned sidecar format made of a 48 octets
+  header followed by fixed size 32 octets entries, all values are big-endian.
+  A memory mapped sidecar can be accessed in place with EbmlIndex::EntryAt().
+  The sidecar keeps the file size and the CRC-32 of the start of the file to
+  detect when it doesn't match the file anymore.
+*/
+class EBML_DLL_API EbmlIndex {
+  public:
+    static constexpr std::uint32_t NoParent = 0xFFFFFFFF;
+    static constexpr std::uint32_t FormatVersion = 1;
+    static constexpr std::size_t HeaderSize = 48;
+    static constexpr std::size_t EntrySize = 32;
+    /// amount of octets at the start of the file used to identify it
+    static constexpr std::size_t IdentitySize = 64 * 1024;
+
+    /*!
+      \brief scan a file and record all the elements up to \a MaxDepth levels (0 for top level elements only)
+      \param Context the semantic context of the top level elements
+      \note global elements, like EbmlVoid, are recorded as children of the level they are found in
+      \note the scan stops at an element with an unknown size that is not scanned, see IsTruncated()
+    */
+    static EbmlIndex Build(IOCallback & File, const EbmlSemanticContext & Context, unsigned int MaxDepth);
+
+    /// create a new reader of the indexed file, for each thread of BuildParallel()
+    using FileOpener = std::function<std::unique_ptr<IOCallback>()>;
+
+    /*!
+      \brief scan the elements of \a Context between \a Start and \a End using \a Ranges threads
+      \param End the end of the scanned area, 0 for the end of the file
+
+      Each thread finds the first element of the context in its part of the
+      file and records the elements up to the start of the next part. The
+      result is the same as a sequential scan of the same area: a part where
+      the resynchronization didn't match an element of the sequential scan is
+      scanned again from the end of the previous part.
+      For example the elements of a Matroska Segment can be scanned in parallel
+      using the Segment data as the area and its context.
+      Entries at depth 0 have no parent.
+    */
+    static EbmlIndex BuildParallel(const FileOpener & OpenFile, const EbmlSemanticContext & Context, unsigned int MaxDepth,
+                                   unsigned int Ranges, std::uint64_t Start = 0, std::uint64_t End = 0);
+
+    /*!
+      \brief write the index in the sidecar format
+    */
+    void Write(IOCallback & Sidecar) const;
+
+    /*!
+      \brief load an index from a sidecar
+      \param File the indexed file, used to check the sidecar still matches it
+      \return false if the sidecar is invalid, from another version or doesn't match the file
+    */
+    bool Read(IOCallback & Sidecar, IOCallback & File);
+
+    /*!
+      \brief load an index from a sidecar in memory
+      \return false if the sidecar is invalid, from another version or doesn't match the file
+    */
+    bool Load(const binary * Sidecar, std::size_t SidecarSize, IOCallback & File);
+
+    /*!
+      \brief read one entry of a sidecar in memory, without loading the whole index
+      \return false if the sidecar is invalid or the entry doesn't exist
+    */
+    static bool EntryAt(const binary * Sidecar, std::size_t SidecarSize, std::size_t Index, EbmlIndexEntry & Entry);
+
+    /*!
+      \brief tell if the index was built from \a File
+    */
+    bool Matches(IOCallback & File) const;
+
+    /*!
+      \brief tell if the scan stopped on an element with an unknown size before the end of the file
+      \note the last entry is that element, the elements after it are not in the index
+    */
+    bool IsTruncated() const { return Truncated; }
+
+    std::size_t size() const { return Entries.size(); }
+    bool empty() const { return Entries.empty(); }
+    const EbmlIndexEntry & operator[](std::size_t Index) const { return Entries[Index]; }
+    std::vector<EbmlIndexEntry>::const_iterator begin() const { return Entries.begin(); }
+    std::vector<EbmlIndexEntry>::const_iterator end() const { return Entries.end(); }
+
+    /*!
+      \brief find the next entry with the given ID
+      \return the index of the entry or size() if there is none
+    */
+    std::size_t Find(const EbmlId & Id, std::size_t From = 0) const;
+
+    /*!
+      \brief create the element of an entry, the file is positioned at the start of its data
+      \param Context the semantic context of the parent of the element
+      \note the user will have to delete that element later
+      \return nullptr if the element was not found at the indexed position
+    */
+    EbmlElement * OpenElement(IOCallback & File, std::size_t Index, const EbmlSemanticContext & Context) const;
+
+  private:
+    struct FileIdentity {
+      std::uint64_t Size{0};
+      std::uint32_t StartCrc{0};
+    };
+    static FileIdentity Identify(IOCallback & File);
+    static void DecodeEntry(const binary * Buffer, EbmlIndexEntry & Entry);
+
+    std::vector<EbmlIndexEntry> Entries;
+    FileIdentity Identity;
+    std::uint32_t MaxDepth{0};
+    bool Truncated{false};
+};
+
+} // namespace libebml
+
+#endif // LIBEBML_INDEX_H
@@ -8,6 +8,11 @@
 #ifndef LIBEBML_MASTER_H
 #define LIBEBML_MASTER_H
 
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "EbmlElement.h"
@@ -30,6 +35,7 @@ class EBML_DLL_API EbmlMaster : public EbmlElement {
   public:
     explicit EbmlMaster(const EbmlCallbacksMaster &, bool bSizeIsKnown = true);
     EbmlMaster(const EbmlMaster & ElementToClone);
+    EbmlMaster(EbmlMaster && ElementToMove) noexcept;
     EbmlMaster& operator=(const EbmlMaster&) = delete;
     bool SizeIsValid(std::uint64_t /*size*/) const override {return true;}
     /*!
@@ -37,16 +43,65 @@ class EBML_DLL_API EbmlMaster : public EbmlElement {
     */
     ~EbmlMaster() override;
 
+    /*!
+      \brief masters created while an object of this class exists don't get their mandatory children
+      \note used by the parser, the children of these masters are read from the stream,
+      the missing ones are created when asked with GetChild()
+    */
+    class EBML_DLL_API CreateForReading {
+      public:
+        CreateForReading();
+        ~CreateForReading();
+        CreateForReading(const CreateForReading &) = delete;
+        CreateForReading & operator=(const CreateForReading &) = delete;
+
+      private:
+        bool bPrevious;
+    };
+
+    /*!
+      \brief copies of this master share their children until they are modified
+      \note the setting is applied to the child masters and is inherited by the copies
+      \note children are copied when accessed with a non-const method (GetChild(),
+      non-const iterators, operator[], Remove(), Detach()...), don't modify the
+      elements returned by const methods, the pointers returned by const methods like
+      FindChild() are shared with the other copies
+      \note copies of the same master can be created concurrently, other uses of masters
+      sharing children, including reading them, are not thread-safe
+      \warning rendering a shared child updates its size and position for all the
+      masters it's shared with, masters sharing children should not be rendered concurrently
+    */
+    void EnableCopyOnWrite(bool bIsEnabled = true);
+    bool IsCopyOnWrite() const {return bCopyOnWrite;}
+
     constexpr const EbmlSemanticContextMaster & ContextMaster() const
     {
       return static_cast<const EbmlSemanticContextMaster &>(Context());
     }
 
     filepos_t RenderData(IOCallback & output, bool bForceRender, const ShouldWrite & writeFilter = WriteSkipDefault) override;
+    /*!
+      \brief render the master like Render() with the children rendered concurrently
+      \param Threads maximum number of children rendered at the same time,
+      each child is rendered in its own memory buffer written to \a output in order
+      \note the output and the positions of the elements are the same as with Render()
+      \note masters with an unknown size are rendered with Render(), as well as masters with
+      children shared with copy-on-write or read from another stream or callback, like deferred
+      EbmlBinary payloads or EbmlRawElement, which can't be used by several threads
+      \note the EbmlStats trace callback is called from the rendering threads for the children
+      and their elements, the parser counters are not affected by rendering
+      \warning \a writeFilter is called from several threads at the same time and must be thread-safe
+      \throws std::runtime_error if a child is rendered larger than the size computed for it
+    */
+    filepos_t RenderParallel(IOCallback & output, unsigned Threads, const ShouldWrite & writeFilter = WriteSkipDefault, bool bKeepPosition = false, bool bForceRender = false);
     filepos_t ReadData(IOCallback & input, ScopeMode ReadFully) override;
     filepos_t UpdateSize(const ShouldWrite & writeFilter = WriteSkipDefault, bool bForceRender = false) override;
 
     bool PushElement(EbmlElement & element);
+    /*!
+      \brief add an element at the end of the list, the master takes ownership of it
+    */
+    bool PushElement(std::unique_ptr<EbmlElement> element);
     std::uint64_t GetSize() const override {
       if (IsFiniteSize())
         return EbmlElement::GetSize();
@@ -75,6 +130,19 @@ class EBML_DLL_API EbmlMaster : public EbmlElement {
     bool InsertElement(EbmlElement & element, std::size_t position = 0);
     bool InsertElement(EbmlElement & element, const EbmlElement & before);
 
+    /*!
+      \brief add elements at a specified location in a single pass, the master takes ownership of them
+      \return false if \a position is past the end of the list, the elements are not added
+    */
+    bool InsertElements(std::vector<std::unique_ptr<EbmlElement>> elements, std::size_t position);
+    /*!
+      \brief add elements at the end of the list, the master takes ownership of them
+    */
+    void PushElements(std::vector<std::unique_ptr<EbmlElement>> elements);
+
+    /// allocate the list for \a Count children
+    void Reserve(std::size_t Count) {ElementList.reserve(Count);}
+
     /*!
       \brief Read the data and keep the known children
     */
@@ -82,23 +150,69 @@ class EBML_DLL_API EbmlMaster : public EbmlElement {
 
     /*!
       \brief sort Data when they can
+      \see SortBy() to sort large lists
     */
     void Sort();
 
+    /*!
+      \brief sort the children by the key returned by \a KeyOf
+      \note the key of each child is computed once, children with the same key keep their order
+    */
+    template <typename KeyFunc>
+    void SortBy(KeyFunc KeyOf)
+    {
+      using Key = typename std::decay<decltype(KeyOf(std::declval<const EbmlElement &>()))>::type;
+      std::vector<std::pair<Key, EbmlElement *>> Keys;
+      Keys.reserve(ElementList.size());
+      for (auto Element : ElementList)
+        Keys.emplace_back(KeyOf(*Element), Element);
+      std::stable_sort(Keys.begin(), Keys.end(), [](const std::pair<Key, EbmlElement *> & A, const std::pair<Key, EbmlElement *> & B) {
+        return A.first < B.first;
+      });
+      for (std::size_t i = 0; i < Keys.size(); i++)
+        ElementList[i] = Keys[i].second;
+    }
+
+    /*!
+      \brief find the first child with a key not smaller than \a Value in a list sorted with SortBy()
+      \return the index of the child, ListSize() if there is none
+    */
+    template <typename Key, typename KeyFunc>
+    std::size_t LowerBound(const Key & Value, KeyFunc KeyOf) const
+    {
+      auto Itr = std::lower_bound(ElementList.begin(), ElementList.end(), Value, [&KeyOf](const EbmlElement * Element, const Key & Cmp) {
+        return KeyOf(*Element) < Cmp;
+      });
+      return static_cast<std::size_t>(Itr - ElementList.begin());
+    }
+
+    /*!
+      \brief find the first child with a key greater than \a Value in a list sorted with SortBy()
+      \return the index of the child, ListSize() if there is none
+    */
+    template <typename Key, typename KeyFunc>
+    std::size_t UpperBound(const Key & Value, KeyFunc KeyOf) const
+    {
+      auto Itr = std::upper_bound(ElementList.begin(), ElementList.end(), Value, [&KeyOf](const Key & Cmp, const EbmlElement * Element) {
+        return Cmp < KeyOf(*Element);
+      });
+      return static_cast<std::size_t>(Itr - ElementList.begin());
+    }
+
     std::size_t ListSize() const {return ElementList.size();}
     std::vector<EbmlElement *> const &GetElementList() const {return ElementList;}
-    std::vector<EbmlElement *> &GetElementList() {return ElementList;}
+    std::vector<EbmlElement *> &GetElementList() {UnshareAll(); return ElementList;}
 
-        inline EBML_MASTER_ITERATOR begin() {return ElementList.begin();}
-        inline EBML_MASTER_ITERATOR end() {return ElementList.end();}
-        inline EBML_MASTER_RITERATOR rbegin() {return ElementList.rbegin();}
-        inline EBML_MASTER_RITERATOR rend() {return ElementList.rend();}
+        inline EBML_MASTER_ITERATOR begin() {UnshareAll(); return ElementList.begin();}
+        inline EBML_MASTER_ITERATOR end() {UnshareAll(); return ElementList.end();}
+        inline EBML_MASTER_RITERATOR rbegin() {UnshareAll(); return ElementList.rbegin();}
+        inline EBML_MASTER_RITERATOR rend() {UnshareAll(); return ElementList.rend();}
         inline EBML_MASTER_CONST_ITERATOR begin() const {return ElementList.begin();}
         inline EBML_MASTER_CONST_ITERATOR end() const {return ElementList.end();}
         inline EBML_MASTER_CONST_RITERATOR rbegin() const {return ElementList.rbegin();}
         inline EBML_MASTER_CONST_RITERATOR rend() const {return ElementList.rend();}
 
-    EbmlElement * operator[](unsigned int position) {return ElementList[position];}
+    EbmlElement * operator[](unsigned int position) {return Unshare(position);}
     const EbmlElement * operator[](unsigned int position) const {return ElementList[position];}
 
     bool IsDefaultValue() const override {
@@ -106,6 +220,8 @@ class EBML_DLL_API EbmlMaster : public EbmlElement {
     }
     bool IsMaster() const override {return true;}
 
+    void AddMemoryUsage(EbmlMemoryReport & Report) const override;
+
     /*!
       \brief verify that all mandatory elements are present
       \note usefull after reading or before writing
@@ -113,7 +229,25 @@ class EBML_DLL_API EbmlMaster : public EbmlElement {
     bool CheckMandatory() const;
 
     /*!
-      \brief Remove an element from the list of the master
+      \brief semantic errors found in the children of a master by CheckSemantic()
+    */
+    struct SemanticReport {
+      std::vector<const EbmlCallbacks *> Missing;    ///< mandatory elements without a default value not found
+      std::vector<const EbmlCallbacks *> Duplicated; ///< unique elements found more than once
+    };
+
+    /*!
+      \brief find the missing mandatory elements and the duplicated unique elements
+      \note the children are checked in a single pass, it can be used in release builds
+      \note \a Report is cleared before the check
+      \return true if no error was found
+    */
+    bool CheckSemantic(SemanticReport & Report) const;
+
+    /*!
+      \brief Remove an element from the list of the master, the caller owns the removed element
+      \note a child shared with other masters is released rather than given to the caller,
+      use Detach() to own it
     */
     void Remove(std::size_t Index);
     void Remove(EBML_MASTER_ITERATOR & Itr);
@@ -121,34 +255,124 @@ class EBML_DLL_API EbmlMaster : public EbmlElement {
 
     /*!
       \brief remove all elements, even the mandatory ones
+      \note children shared with other masters are released
+    */
+    void RemoveAll() {ElementList.clear(); SharedElements.clear();}
+
+    /*!
+      \brief Remove an element from the list of the master and give its ownership to the caller
+      \return nullptr if the element is not in the list
+    */
+    std::unique_ptr<EbmlElement> Detach(std::size_t Index);
+    std::unique_ptr<EbmlElement> Detach(const EbmlElement & Element);
+
+    /*!
+      \brief Remove all elements from the list of the master and give their ownership to the caller
     */
-    void RemoveAll() {ElementList.clear();}
+    std::vector<std::unique_ptr<EbmlElement>> DetachAll();
+
+    using ChildPredicate = std::function<bool(const EbmlElement &)>;
+    /*!
+      \brief delete the children matching \a Predicate in a single pass, keeping the order of the others
+      \note children shared with other masters are released
+      \return the number of children removed
+    */
+    std::size_t RemoveIf(const ChildPredicate & Predicate);
+    /*!
+      \brief remove the children matching \a Predicate in a single pass and give their ownership to the caller
+      \note children shared with other masters are copied
+    */
+    std::vector<std::unique_ptr<EbmlElement>> DetachIf(const ChildPredicate & Predicate);
 
     /*!
       \brief facility for Master elements to write only the head and force the size later
     */
     filepos_t WriteHead(IOCallback & output, unsigned int SizeLength, const ShouldWrite& writeFilter = WriteSkipDefault);
 
-    void EnableChecksum(bool bIsEnabled = true) { bChecksumUsed = bIsEnabled; }
-    bool HasChecksum() const {return bChecksumUsed;}
+    void EnableChecksum(bool bIsEnabled = true) {
+      if (!bIsEnabled)
+        Checksum.reset();
+      else if (!Checksum)
+        Checksum = std::make_unique<EbmlCrc32>();
+    }
+    bool HasChecksum() const {return static_cast<bool>(Checksum);}
     bool VerifyChecksum() const;
-    std::uint32_t GetCrc32() const {return Checksum.GetCrc32();}
+    std::uint32_t GetCrc32() const {return Checksum ? Checksum->GetCrc32() : 0;}
     void ForceChecksum(std::uint32_t NewChecksum) {
-      Checksum.ForceCrc32(NewChecksum);
-      bChecksumUsed = true;
+      EnableChecksum();
+      Checksum->ForceCrc32(NewChecksum);
     }
 
+  protected:
+    /*!
+      \brief take the children of a master of the same class
+      \note only the concrete master classes can be move assigned, so the children
+      stay in their semantic context
+    */
+    EbmlMaster& operator=(EbmlMaster && ElementToMove) noexcept;
+
     private:
     std::vector<EbmlElement *> ElementList;
 
-    bool      bChecksumUsed = bChecksumUsedByDefault;
-    EbmlCrc32 Checksum;
+    /// only allocated when the master uses a CRC-32
+    std::unique_ptr<EbmlCrc32> Checksum;
+
+    bool      bCopyOnWrite = false;
+    /// children of ElementList shared with other masters, sorted by address
+    mutable std::vector<std::shared_ptr<EbmlElement>> SharedElements;
 
   private:
+    bool ScanSemantic(SemanticReport * Report) const;
+
+    /*!
+      \brief read the whole payload at once and parse the children from memory
+      \return false if the payload could not be read, nothing has been parsed
+    */
+    bool ReadInMemory(EbmlStream & inDataStream, const EbmlSemanticContext & Context, int & UpperEltFound, EbmlElement * & FoundElt, bool AllowDummyElt);
+
     /*!
       \brief Add all the mandatory elements to the list
     */
     bool ProcessMandatory();
+
+    /// whether this master or its children use state shared with other elements or streams
+    bool HasSharedState() const;
+
+    bool IsShared(const EbmlElement * Element) const;
+    /*!
+      \brief make all the children shareable with a copy of this master
+      \note serialized between concurrent copies
+    */
+    void ShareAll() const;
+    /*!
+      \brief remove \a Element from the children shared with other masters
+      \return false if it was not shared
+    */
+    bool ReleaseShared(const EbmlElement * Element);
+    /*!
+      \brief replace the element at Index by a copy if it's shared with other masters
+      \return the element now at Index
+    */
+    EbmlElement * Unshare(std::size_t Index);
+    void UnshareAll() {
+      if (!SharedElements.empty())
+        UnshareElements();
+    }
+    void UnshareElements();
+    /// a child removed from the list, owned by the caller or shared with other masters
+    struct ExtractedChild {
+      std::unique_ptr<EbmlElement> Owned;
+      std::shared_ptr<EbmlElement> Shared;
+    };
+    /*!
+      \brief remove the children matching \a Predicate, in their order in the list
+      \note the list is not modified if \a Predicate throws
+    */
+    std::vector<ExtractedChild> ExtractIf(const ChildPredicate & Predicate);
+    /*!
+      \brief delete the children owned by this master and release the shared ones
+    */
+    void DeleteElements();
 };
 
 static inline constexpr const EbmlSemanticContextMaster & tEBML_CONTEXT(const EbmlMaster * e)
@@ -188,12 +412,57 @@ Type * FindNextChild(const EbmlMaster & Master, const Type & PastElt)
   return static_cast<Type *>(Master.FindNextElt(PastElt));
 }
 
+template <typename Type>
+std::unique_ptr<Type> DetachChild(EbmlMaster & Master, const Type & Child)
+{
+  return std::unique_ptr<Type>(static_cast<Type *>(Master.Detach(Child).release()));
+}
+
 template <typename Type>
 Type & AddNewChild(EbmlMaster & Master)
 {
   return *(static_cast<Type *>(Master.AddNewElt(EBML_INFO(Type))));
 }
 
+template <typename Type>
+using ChildValue = typename std::decay<decltype(std::declval<const Type &>().GetValue())>::type;
+
+/*!
+  \brief sorting key of a master by the value of its \a Type child
+  \note elements without such a child are sorted after the others
+*/
+template <typename Type>
+std::pair<bool, ChildValue<Type>> ChildSortKey(const EbmlElement & Element)
+{
+  const Type * Child = Element.IsMaster() ? FindChild<Type>(static_cast<const EbmlMaster &>(Element)) : nullptr;
+  if (Child == nullptr)
+    return {true, ChildValue<Type>()};
+  return {false, Child->GetValue()};
+}
+
+/// sort the children of \a Master by the value of their \a Type child, like the CueTime of CuePoints
+template <typename Type>
+void SortByChild(EbmlMaster & Master)
+{
+  Master.SortBy(ChildSortKey<Type>);
+}
+// call with
+// SortByChild<KaxCueTime>(Cues);
+
+/// index of the first child of \a Master sorted with SortByChild() with a \a Type child not smaller than \a Value
+template <typename Type>
+std::size_t LowerBoundChild(const EbmlMaster & Master, const ChildValue<Type> & Value)
+{
+  return Master.LowerBound(std::make_pair(false, Value), ChildSortKey<Type>);
+}
+
+/// index of the first child of \a Master sorted with SortByChild() with a \a Type child greater than \a Value
+template <typename Type>
+std::size_t UpperBoundChild(const EbmlMaster & Master, const ChildValue<Type> & Value)
+{
+  return Master.UpperBound(std::make_pair(false, Value), ChildSortKey<Type>);
+}
+
 } // namespace libebml
 
 #endif // LIBEBML_MASTER_H
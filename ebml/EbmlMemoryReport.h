@@ -0,0 +1,69 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \brief memory used by a tree of elements
+*/
+#ifndef LIBEBML_MEMORY_REPORT_H
+#define LIBEBML_MEMORY_REPORT_H
+
+#include "EbmlConfig.h"
+#include "EbmlTypes.h"
+
+#include <map>
+#include <string>
+
+namespace libebml {
+
+class EbmlElement;
+
+/*!
+  \brief memory used by a group of elements
+*/
+struct EBML_DLL_API EbmlMemoryUsage {
+  std::size_t Elements{0};   ///< number of elements
+  std::size_t Objects{0};    ///< octets used by the element objects
+  std::size_t Payload{0};    ///< octets allocated outside the objects for the values
+  std::size_t Containers{0}; ///< octets allocated by the masters to hold their children
+
+  std::size_t Total() const { return Objects + Payload + Containers; }
+};
+
+/*!
+  \class EbmlMemoryReport
+  \brief memory used by a tree of elements, in total and per element ID
+
+  The heap allocator overhead is not counted. Children shared between
+  copies of a master are counted in each tree they belong to.
+*/
+class EBML_DLL_API EbmlMemoryReport {
+  public:
+    struct IdUsage : EbmlMemoryUsage {
+      const char * Name{nullptr};
+    };
+
+    /// add the memory used by one element, not including its children
+    void Add(const EbmlElement & Element, std::size_t Object, std::size_t Payload, std::size_t Containers = 0);
+
+    const EbmlMemoryUsage & GetTotal() const { return Total; }
+    /// memory used by the elements of each ID, indexed by the ID value
+    const std::map<std::uint32_t, IdUsage> & GetPerId() const { return PerId; }
+
+    /// octets allocated outside of the string object to hold its characters
+    static std::size_t StringAllocation(const std::string & String) {
+      const auto * Chars = String.data();
+      const auto * Object = reinterpret_cast<const char *>(&String);
+      if (Chars >= Object && Chars < Object + sizeof(String))
+        return 0; // small string stored in the object
+      return String.capacity() + 1;
+    }
+
+  private:
+    EbmlMemoryUsage Total;
+    std::map<std::uint32_t, IdUsage> PerId;
+};
+
+} // namespace libebml
+
+#endif // LIBEBML_MEMORY_REPORT_H
@@ -0,0 +1,62 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \brief element copied as-is from another stream
+*/
+#ifndef LIBEBML_RAW_ELEMENT_H
+#define LIBEBML_RAW_ELEMENT_H
+
+#include "EbmlElement.h"
+
+namespace libebml {
+
+/*!
+  \class EbmlRawElement
+  \brief element kept in its source stream and rendered by copying its octets
+
+  The data are never parsed nor loaded in memory, rendering copies them with
+  IOCallback::CopyFrom(), which may use a system copy between files.
+  The head is rendered with the ID, size and size length of the source so the
+  element is copied byte-exact.
+  \note the source stream must remain valid as long as the element is used
+*/
+class EBML_DLL_API EbmlRawElement : public EbmlElement {
+  public:
+    /*!
+      \brief refer to an element of \a Source without reading its data
+      \param Element an element with a known size found in \a Source
+    */
+    EbmlRawElement(IOCallback & Source, const EbmlElement & Element);
+    EbmlRawElement(const EbmlRawElement &) = default;
+
+    bool SizeIsValid(std::uint64_t) const override {return true;}
+    bool IsDefaultValue() const override {return false;}
+
+    filepos_t RenderData(IOCallback & output, bool bForceRender, const ShouldWrite & writeFilter = WriteSkipDefault) override;
+    /// use the data at the current position of \a input as the source, without reading them
+    filepos_t ReadData(IOCallback & input, ScopeMode ReadFully = SCOPE_ALL_DATA) override;
+    filepos_t UpdateSize(const ShouldWrite & writeFilter = WriteSkipDefault, bool bForceRender = false) override;
+
+    EbmlId const &GetClassId() const override { return RawId; }
+    EbmlElement * Clone() const override { return new EbmlRawElement(*this); }
+
+    std::size_t ObjectSize() const override { return sizeof(EbmlRawElement); }
+
+    IOCallback & GetSource() const { return *Source; }
+    /// position of the data in the source
+    std::uint64_t GetSourcePosition() const { return SourcePosition; }
+
+  private:
+    static const EbmlCallbacks ClassInfos;
+    static constexpr EbmlId DefaultRawId{0xFF};
+
+    IOCallback * Source;
+    const EbmlId RawId;
+    std::uint64_t SourcePosition;
+};
+
+} // namespace libebml
+
+#endif // LIBEBML_RAW_ELEMENT_H
@@ -0,0 +1,221 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \brief decode masters with a known layout straight into plain structures
+*/
+#ifndef LIBEBML_SCHEMA_H
+#define LIBEBML_SCHEMA_H
+
+#include "EbmlElement.h"
+#include "EbmlUInteger.h"
+#include "EbmlSInteger.h"
+#include "EbmlFloat.h"
+#include "EbmlDate.h"
+#include "EbmlString.h"
+#include "EbmlUnicodeString.h"
+#include "EbmlBinary.h"
+#include "EbmlMaster.h"
+#include "EbmlEndian.h"
+#include "IOCallback.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace libebml {
+
+/*!
+  \brief a member of a plain structure holding the value of the \a Element child of a master
+  \tparam Member pointer to the structure member receiving the value
+  \tparam Element the element class declared with the DECLARE_xxx macros
+
+  The member type must match the element type:
+  - std::uint64_t (or any integer type) for EbmlUInteger,
+  - std::int64_t for EbmlSInteger,
+  - std::int64_t for EbmlDate, as a UNIX/C/EPOCH date like EbmlDate::GetValue(),
+  - double (or float) for EbmlFloat,
+  - std::string for EbmlString,
+  - UTFstring or std::string (UTF-8) for EbmlUnicodeString,
+  - std::vector<binary> for EbmlBinary.
+*/
+template<auto Member, typename Element>
+struct EbmlSchemaField {
+  using ElementType = Element;
+  static constexpr auto Target = Member;
+};
+
+/*!
+  \class EbmlSchema
+  \brief decode the payload of a \a Master directly in a plain \a Struct
+
+  The table of \a Fields is resolved at compile time: each child matching one
+  of the fields is decoded in place by a decoder specialized for its element
+  type, without creating any EbmlElement and without virtual calls.
+  Children not in the table (CRC-32, Void, unknown elements) are skipped.
+  Fields start with the default value of their element, when it has one.
+  When a child is found more than once the last value is kept.
+
+  \note only leaf elements can be fields, masters have to use their own schema.
+*/
+template<typename Master, typename Struct, typename... Fields>
+class EbmlSchema {
+  public:
+    /*!
+      \brief set all the fields that have a default value to their default value
+    */
+    static void SetDefaults(Struct & Data) {
+      (SetDefault<Fields>(Data), ...);
+    }
+
+    /*!
+      \brief decode the payload of a master in memory
+      \return false if the payload is not a valid list of finite size elements
+    */
+    static bool Decode(const binary * Buffer, std::size_t BufferSize, Struct & Data) {
+      SetDefaults(Data);
+
+      const binary * Cursor = Buffer;
+      const binary * const End = Buffer + BufferSize;
+      while (Cursor != End) {
+        auto Available = static_cast<std::size_t>(End - Cursor);
+
+        // 1 to 4 octets, the length is given by the position of the first bit set
+        std::size_t IdLength = 1;
+        while (IdLength <= 4 && !(Cursor[0] & (0x80 >> (IdLength - 1))))
+          IdLength++;
+        if (IdLength > 4 || IdLength >= Available)
+          return false;
+        std::uint32_t IdValue = 0;
+        for (std::size_t i = 0; i < IdLength; i++)
+          IdValue = (IdValue << 8) | Cursor[i];
+        Cursor += IdLength;
+        Available -= IdLength;
+
+        auto SizeLength = static_cast<std::uint32_t>(std::min<std::size_t>(Available, 8));
+        std::uint64_t SizeUnknown;
+        const std::uint64_t ElementSize = ReadCodedSizeValue(Cursor, SizeLength, SizeUnknown);
+        if (SizeLength == 0 || ElementSize == SizeUnknown)
+          return false;
+        Cursor += SizeLength;
+        Available -= SizeLength;
+        if (ElementSize > Available)
+          return false;
+
+        const auto Payload = static_cast<std::size_t>(ElementSize);
+        (void)(DecodeField<Fields>(IdValue, Cursor, Payload, Data) || ...);
+        Cursor += Payload;
+      }
+      return true;
+    }
+
+    /*!
+      \brief read and decode the payload of a master found in the stream
+      \param input the stream, positioned at the start of the payload of \a Element
+      \param Element the master head, as returned by EbmlStream::FindNextID()
+      \return false if \a Element is not a finite size \a Master or its payload is invalid
+    */
+    static bool Read(IOCallback & input, const EbmlElement & Element, Struct & Data) {
+      if (Element.GetClassId() != EBML_ID(Master) || !Element.IsFiniteSize())
+        return false;
+      if (Element.GetSize() > std::numeric_limits<std::size_t>::max())
+        return false;
+
+      std::vector<binary> Payload(static_cast<std::size_t>(Element.GetSize()));
+      input.readFully(Payload.data(), Payload.size());
+      return Decode(Payload.data(), Payload.size(), Data);
+    }
+
+  private:
+    template<typename T>
+    static std::true_type HasDefaultValue(const EbmlCallbacksWithDefault<T> &);
+    static std::false_type HasDefaultValue(const EbmlCallbacks &);
+
+    template<typename Field>
+    using MemberType = std::remove_reference_t<decltype(std::declval<Struct &>().*Field::Target)>;
+
+    template<typename Field>
+    static void SetDefault(Struct & Data) {
+      using Element = typename Field::ElementType;
+      static_assert(!std::is_base_of_v<EbmlMaster, Element>, "masters can't be decoded as a field");
+      if constexpr (decltype(HasDefaultValue(Element::GetElementSpec()))::value) {
+        if constexpr (std::is_base_of_v<EbmlUnicodeString, Element> && std::is_same_v<MemberType<Field>, std::string>) {
+          UTFstring Default;
+          Default = Element::GetElementSpec().DefaultValue();
+          Data.*Field::Target = Default.GetUTF8();
+        } else {
+          Data.*Field::Target = Element::GetElementSpec().DefaultValue();
+        }
+      }
+    }
+
+    /// strings stop at the first 0 octet, like EbmlString::ReadData()
+    static void AssignString(std::string & Value, const binary * Buffer, std::size_t Size) {
+      const auto * Chars = reinterpret_cast<const char *>(Buffer);
+      const auto * Nul = static_cast<const char *>(std::memchr(Chars, 0, Size));
+      Value.assign(Chars, Nul != nullptr ? static_cast<std::size_t>(Nul - Chars) : Size);
+    }
+
+    template<typename Field>
+    static bool DecodeField(std::uint32_t IdValue, const binary * Buffer, std::size_t Size, Struct & Data) {
+      using Element = typename Field::ElementType;
+      if (IdValue != EBML_ID_VALUE(EBML_ID(Element)))
+        return false;
+
+      auto & Value = Data.*Field::Target;
+      if constexpr (std::is_base_of_v<EbmlUInteger, Element>) {
+        if (Size <= 8) {
+          std::uint64_t val = 0;
+          for (std::size_t i = 0; i < Size; i++)
+            val = (val << 8) | Buffer[i];
+          Value = static_cast<MemberType<Field>>(val);
+        }
+      } else if constexpr (std::is_base_of_v<EbmlSInteger, Element>) {
+        if (Size <= 8) {
+          std::uint64_t val = Size != 0 && Buffer[0] & 0x80 ? std::numeric_limits<std::uint64_t>::max() : 0;
+          for (std::size_t i = 0; i < Size; i++)
+            val = (val << 8) | Buffer[i];
+          Value = static_cast<MemberType<Field>>(static_cast<std::int64_t>(val));
+        }
+      } else if constexpr (std::is_base_of_v<EbmlDate, Element>) {
+        if (Size == 8)
+          Value = EbmlDate::EbmlToEpoch(endian::from_big64(Buffer));
+      } else if constexpr (std::is_base_of_v<EbmlFloat, Element>) {
+        if (Size == 0) {
+          Value = static_cast<MemberType<Field>>(0.0);
+        } else if (Size == 4) {
+          auto tmpp = endian::from_big32(Buffer);
+          float val;
+          std::memcpy(&val, &tmpp, 4);
+          Value = static_cast<MemberType<Field>>(val);
+        } else if (Size == 8) {
+          auto tmpp = endian::from_big64(Buffer);
+          double val;
+          std::memcpy(&val, &tmpp, 8);
+          Value = static_cast<MemberType<Field>>(val);
+        }
+      } else if constexpr (std::is_base_of_v<EbmlString, Element>) {
+        AssignString(Value, Buffer, Size);
+      } else if constexpr (std::is_base_of_v<EbmlUnicodeString, Element>) {
+        if constexpr (std::is_same_v<MemberType<Field>, std::string>) {
+          AssignString(Value, Buffer, Size);
+        } else {
+          Value.SetUTF8(std::string_view{reinterpret_cast<const char *>(Buffer), Size}); // cut at the first 0
+        }
+      } else if constexpr (std::is_base_of_v<EbmlBinary, Element>) {
+        Value.assign(Buffer, Buffer + Size);
+      } else {
+        static_assert(!std::is_same_v<Element, Element>, "unsupported element type in schema");
+      }
+      return true;
+    }
+};
+
+} // namespace libebml
+
+#endif // LIBEBML_SCHEMA_H
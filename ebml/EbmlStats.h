@@ -0,0 +1,115 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \brief parser counters and tracing hooks, only active with the EBML_ENABLE_STATS build option
+*/
+#ifndef LIBEBML_STATS_H
+#define LIBEBML_STATS_H
+
+#include "EbmlConfig.h"
+#include "EbmlTypes.h"
+
+#include <atomic>
+
+namespace libebml {
+
+class EbmlElement;
+
+/*!
+  \brief counters of the parser operations done in a thread
+*/
+struct EBML_DLL_API EbmlParserStats {
+  std::uint64_t ResyncBytes{0};          ///< octets skipped by FindNextElement() to find an element
+  std::uint64_t DummyElements{0};        ///< unknown elements created as EbmlDummy
+  std::uint64_t GlobalContextLookups{0}; ///< IDs not found in the context looked for in the global context
+  std::uint64_t ParentContextLookups{0}; ///< IDs not found in the context looked for in a parent context
+  std::uint64_t ElementsCreated{0};      ///< elements created by EbmlMaster::Read()
+  std::uint64_t ElementsDeleted{0};      ///< elements discarded by EbmlMaster::Read()
+};
+
+enum class EbmlTraceEvent {
+  ReadBegin,
+  ReadEnd,
+  RenderBegin,
+  RenderEnd,
+};
+
+/*!
+  \brief function called when an element starts and ends being read or rendered
+  \note it may be called from any thread reading or writing elements
+*/
+using EbmlTraceCallback = void (*)(EbmlTraceEvent Event, const EbmlElement & Element, void * Opaque);
+
+/*!
+  \class EbmlStats
+  \brief access to the parser counters and tracing hooks
+
+  When the library is built without EBML_ENABLE_STATS the counters are
+  never updated and the trace callback is never called.
+*/
+class EBML_DLL_API EbmlStats {
+  public:
+#if defined(EBML_ENABLE_STATS)
+    static constexpr bool Enabled = true;
+#else
+    static constexpr bool Enabled = false;
+#endif
+
+    /// counters of the calling thread
+    static EbmlParserStats Snapshot();
+    /// reset the counters of the calling thread
+    static void Reset();
+
+    /*!
+      \brief set the callback for all element reads and renders, nullptr to disable it
+      \param OnlyId only trace the elements with this ID value, 0 for all elements
+      \note it should be set before reading or writing in other threads
+    */
+    static void SetTraceCallback(EbmlTraceCallback Callback, void * Opaque = nullptr, std::uint32_t OnlyId = 0);
+};
+
+#if defined(EBML_ENABLE_STATS)
+/// internal state of EbmlStats, not exported
+struct EbmlStatsState {
+  static thread_local EbmlParserStats Counters;
+  static std::atomic<EbmlTraceCallback> TraceCallback;
+  static void * TraceOpaque;
+  static std::uint32_t TraceId;
+
+  static void Notify(EbmlTraceEvent Event, const EbmlElement & Element);
+};
+
+/// call the trace callback at the start and end of its scope
+class EbmlTraceScope {
+  public:
+    EbmlTraceScope(EbmlTraceEvent aBegin, EbmlTraceEvent aEnd, const EbmlElement & aElement)
+      :End(aEnd), Element(aElement)
+    {
+      if (EbmlStatsState::TraceCallback.load(std::memory_order_acquire) != nullptr)
+        EbmlStatsState::Notify(aBegin, Element);
+    }
+    ~EbmlTraceScope()
+    {
+      if (EbmlStatsState::TraceCallback.load(std::memory_order_acquire) != nullptr)
+        EbmlStatsState::Notify(End, Element);
+    }
+    EbmlTraceScope(const EbmlTraceScope &) = delete;
+    EbmlTraceScope & operator=(const EbmlTraceScope &) = delete;
+
+  private:
+    const EbmlTraceEvent End;
+    const EbmlElement & Element;
+};
+
+#define EBML_STATS_ADD(counter, n)  (libebml::EbmlStatsState::Counters.counter += (n))
+#define EBML_STATS_TRACE(event, e)  const libebml::EbmlTraceScope EbmlTrace_##event(libebml::EbmlTraceEvent::event##Begin, libebml::EbmlTraceEvent::event##End, e)
+#else
+#define EBML_STATS_ADD(counter, n)  do {} while (0)
+#define EBML_STATS_TRACE(event, e)  do {} while (0)
+#endif
+
+} // namespace libebml
+
+#endif // LIBEBML_STATS_H
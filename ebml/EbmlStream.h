@@ -38,8 +38,16 @@ class EBML_DLL_API EbmlStream {
     inline IOCallback & I_O() {return Stream;}
         operator IOCallback &() {return Stream;}
 
+    /*!
+      \brief masters with a known size up to this size are read from this stream with a single read and parsed from memory
+      \note only used with SCOPE_ALL_DATA, 0 (the default) disables it
+    */
+    void SetReadInMemoryThreshold(std::uint64_t MaxSize) {ReadInMemoryThreshold = MaxSize;}
+    std::uint64_t GetReadInMemoryThreshold() const {return ReadInMemoryThreshold;}
+
     private:
     IOCallback & Stream;
+    std::uint64_t ReadInMemoryThreshold{0};
 };
 
 } // namespace libebml
@@ -21,6 +21,9 @@ namespace libebml {
 class EBML_DLL_API EbmlString : public EbmlElementDefaultStorage<const char *, std::string> {
   public:
     EbmlString(const EbmlCallbacksDefault<const char *> &);
+    EbmlString(const EbmlString &) = default;
+    EbmlString(EbmlString &&) noexcept = default;
+    EbmlString& operator=(EbmlString &&) noexcept = default;
 
     bool SizeIsValid(std::uint64_t size) const override {return size < 0x7FFFFFFF;} // any size is possible
     filepos_t RenderData(IOCallback & output, bool bForceRender, const ShouldWrite & writeFilter = WriteSkipDefault) override;
@@ -32,6 +35,10 @@ class EBML_DLL_API EbmlString : public EbmlElementDefaultStorage<const char *, s
     bool operator==(const char * const & val) const override {
       return val == Value;
     }
+
+    void AddMemoryUsage(EbmlMemoryReport & Report) const override {
+      Report.Add(*this, ObjectSize(), EbmlMemoryReport::StringAllocation(Value));
+    }
 };
 
 } // namespace libebml
@@ -0,0 +1,90 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \brief elements of a file read on demand and kept within a memory budget
+*/
+#ifndef LIBEBML_SUBTREE_CACHE_H
+#define LIBEBML_SUBTREE_CACHE_H
+
+#include "EbmlIndex.h"
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+namespace libebml {
+
+/*!
+  \class EbmlSubtreeCache
+  \brief read elements of an indexed file when they are accessed and keep the most recently used ones
+
+  Only the index of the file stays in memory. When an element of the index
+  is accessed it's read with all its children and kept until the memory
+  used by all the read elements, as given by EbmlElement::GetMemoryReport(),
+  exceeds the budget. The least recently used elements are released first.
+  An element that is still used by the caller stays valid after it's been
+  released by the cache.
+  \note an element and one of its children in the index are read and kept separately
+  \note this class is not thread safe, like the IOCallback it reads from
+*/
+class EBML_DLL_API EbmlSubtreeCache {
+  public:
+    struct Statistics {
+      std::uint64_t Hits{0};
+      std::uint64_t Misses{0};
+      std::uint64_t Evictions{0};
+    };
+
+    /*!
+      \param Context the semantic context of the top level elements of the index
+      \param MemoryBudget maximum amount of octets used by the elements kept
+    */
+    EbmlSubtreeCache(IOCallback & File, EbmlIndex Index, const EbmlSemanticContext & Context, std::size_t MemoryBudget);
+    EbmlSubtreeCache(const EbmlSubtreeCache &) = delete;
+    EbmlSubtreeCache & operator=(const EbmlSubtreeCache &) = delete;
+
+    const EbmlIndex & GetIndex() const { return Index; }
+
+    /*!
+      \brief get the element of an index entry, reading it if it's not kept
+      \return nullptr if the element is not found at the indexed position
+    */
+    std::shared_ptr<EbmlElement> Get(std::size_t Entry);
+
+    /// release the least recently used elements, except the last one used, until \a MemoryBudget is not exceeded
+    void SetMemoryBudget(std::size_t MemoryBudget);
+    std::size_t GetMemoryBudget() const { return Budget; }
+    /// memory used by the elements kept
+    std::size_t GetMemoryUsed() const { return Used; }
+    std::size_t GetElementsKept() const { return Kept.size(); }
+
+    /// release all the elements kept
+    void Clear();
+
+    const Statistics & GetStatistics() const { return Stats; }
+
+  private:
+    struct KeptElement {
+      std::shared_ptr<EbmlElement> Element;
+      std::size_t Memory;
+      std::list<std::size_t>::iterator Use;
+    };
+
+    const EbmlSemanticContext & ParentContext(std::size_t Entry) const;
+    void Evict(std::size_t Keep);
+
+    IOCallback & File;
+    const EbmlIndex Index;
+    const EbmlSemanticContext & Context;
+    std::size_t Budget;
+    std::size_t Used{0};
+    std::unordered_map<std::size_t, KeptElement> Kept;
+    std::list<std::size_t> Uses; ///< most recently used entries first
+    Statistics Stats;
+};
+
+} // namespace libebml
+
+#endif // LIBEBML_SUBTREE_CACHE_H
@@ -17,7 +17,8 @@ using filepos_t = std::uint64_t;
 enum ScopeMode {
   SCOPE_PARTIAL_DATA = 0,
   SCOPE_ALL_DATA,
-  SCOPE_NO_DATA
+  SCOPE_NO_DATA,
+  SCOPE_DEFERRED_DATA, ///< binary data are read when they are accessed, other elements are fully read
 };
 
 } // namespace libebml
@@ -27,6 +27,7 @@ public:
   UTFstring() = default;
   UTFstring(const char *); // should be NULL terminated
   UTFstring(const UTFstring &) = default;
+  UTFstring(UTFstring &&) noexcept = default;
   UTFstring(std::wstring const &);
 
   virtual ~UTFstring() = default;
@@ -44,6 +45,7 @@ public:
     return !(*this == cmp);
   }
   UTFstring & operator=(const UTFstring &) = default;
+  UTFstring & operator=(UTFstring &&) noexcept = default;
   UTFstring & operator=(const wchar_t *);
   UTFstring & operator=(wchar_t);
 
@@ -52,6 +54,9 @@ public:
 
   const std::string & GetUTF8() const {return UTF8string;}
   void SetUTF8(std::string_view);
+  /// take the storage of the UTF-8 string, cut at the first 0
+  void SetUTF8(std::string &&);
+  void SetUTF8(const char *_aStr) {SetUTF8(std::string_view{_aStr});}
 
 private:
   std::string UTF8string;
@@ -67,6 +72,9 @@ private:
 class EBML_DLL_API EbmlUnicodeString : public EbmlElementDefaultStorage<const wchar_t *, UTFstring> {
   public:
     EbmlUnicodeString(const EbmlCallbacksDefault<const wchar_t *> &);
+    EbmlUnicodeString(const EbmlUnicodeString &) = default;
+    EbmlUnicodeString(EbmlUnicodeString &&) noexcept = default;
+    EbmlUnicodeString& operator=(EbmlUnicodeString &&) noexcept = default;
 
     bool SizeIsValid(std::uint64_t /*size*/) const override {return true;} // any size is possible
     filepos_t RenderData(IOCallback & output, bool bForceRender, const ShouldWrite & writeFilter = WriteSkipDefault) override;
@@ -81,6 +89,10 @@ class EBML_DLL_API EbmlUnicodeString : public EbmlElementDefaultStorage<const wc
     bool operator==(const wchar_t * const & val) const override {
       return static_cast<UTFstring>(val) == Value;
     }
+
+    void AddMemoryUsage(EbmlMemoryReport & Report) const override {
+      Report.Add(*this, ObjectSize(), EbmlMemoryReport::StringAllocation(Value.GetUTF8()));
+    }
 };
 
 } // namespace libebml
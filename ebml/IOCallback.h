@@ -63,6 +63,13 @@ public:
 
   void writeFully(const void*Buffer,std::size_t Size);
 
+  // Copy Size bytes found at Position in Source to the current position. The
+  // position of Source is restored. The default implementation reads and writes
+  // through a buffer, implementations can use a faster system copy. An exception
+  // is thrown if the Source doesn't have enough data. Source can be this
+  // IOCallback, the source and destination ranges can overlap.
+  virtual std::uint64_t CopyFrom(IOCallback & Source, std::uint64_t Position, std::uint64_t Size);
+
   template<class STRUCT> void writeStruct(const STRUCT&Struct){writeFully(&Struct,sizeof(Struct));}
 };
 
@@ -16,10 +16,24 @@ namespace libebml {
 class EBML_DLL_API MemReadIOCallback : public IOCallback {
 protected:
   std::uint8_t const *mStart, *mEnd, *mPtr;
+  std::uint64_t mBase{0}; ///< file position of mStart
 
 public:
   MemReadIOCallback(void const *Ptr, std::size_t Size);
+  /*!
+    \brief read a part of a file loaded in memory
+    \param BaseOffset the position of \a Ptr in the file, used for all positions of the stream
+  */
+  MemReadIOCallback(void const *Ptr, std::size_t Size, std::uint64_t BaseOffset);
+  /*!
+    \brief read the payload of \a Binary
+    \note a deferred payload is loaded
+  */
   explicit MemReadIOCallback(EbmlBinary const &Binary);
+  /*!
+    \brief read the data left in \a Mem, starting at position 0
+    \note use the BaseOffset constructor with the position of \a Mem to keep the file positions
+  */
   MemReadIOCallback(MemReadIOCallback const &Mem);
   ~MemReadIOCallback() override = default;
   MemReadIOCallback& operator=(const MemReadIOCallback&) = delete;
@@ -27,7 +41,7 @@ public:
   std::size_t read(void *Buffer, std::size_t Size) override;
   void setFilePointer(std::int64_t Offset, seek_mode Mode = seek_beginning) override;
   std::size_t write(void const *, std::size_t) override { return 0; }
-  std::uint64_t getFilePointer() override { return mPtr - mStart; }
+  std::uint64_t getFilePointer() override { return mBase + (mPtr - mStart); }
   void close() override {}
   binary const *GetDataBuffer() const { return mPtr; }
   std::uint64_t GetDataBufferSize() const { return mEnd - mStart; }
@@ -0,0 +1,71 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \brief IOCallback writing in a buffer of the caller
+*/
+#ifndef LIBEBML_MEMWRITEIOCALLBACK_H
+#define LIBEBML_MEMWRITEIOCALLBACK_H
+
+#include "IOCallback.h"
+
+namespace libebml {
+
+/*!
+  \class MemWriteIOCallback
+  \brief write in a fixed size buffer provided by the caller, without any allocation
+
+  The data that don't fit in the buffer are dropped but the writes still
+  succeed, so rendering never throws on overflow. IsOverflow() tells if
+  something was dropped and GetRequiredSize() the buffer size needed to
+  render everything.
+  The data written can be read back and rewritten, for example to patch a
+  header with EbmlElement::OverwriteHead().
+*/
+class EBML_DLL_API MemWriteIOCallback : public IOCallback {
+public:
+  /*!
+    \param BaseOffset the position of \a Ptr in the output, used for all positions of the stream
+  */
+  MemWriteIOCallback(void *Ptr, std::size_t Size, std::uint64_t BaseOffset = 0);
+  ~MemWriteIOCallback() override = default;
+  MemWriteIOCallback(const MemWriteIOCallback&) = delete;
+  MemWriteIOCallback& operator=(const MemWriteIOCallback&) = delete;
+
+  /// read the data written
+  std::size_t read(void *Buffer, std::size_t Size) override;
+  void setFilePointer(std::int64_t Offset, seek_mode Mode = seek_beginning) override;
+  /*!
+    \brief write the data that fit in the buffer
+    \return always \a Size, check IsOverflow() to know if everything was kept
+  */
+  std::size_t write(const void *Buffer, std::size_t Size) override;
+  std::uint64_t getFilePointer() override { return mBase + mPosition; }
+  void close() override {}
+
+  binary *GetDataBuffer() const { return mStart; }
+  /// number of octets written in the buffer
+  std::size_t GetDataBufferSize() const { return mEnd < mCapacity ? static_cast<std::size_t>(mEnd) : mCapacity; }
+  /// whether some data didn't fit in the buffer
+  bool IsOverflow() const { return mEnd > mCapacity; }
+  /// buffer size needed to keep all the data written
+  std::uint64_t GetRequiredSize() const { return mEnd; }
+
+  /// forget the data written to reuse the buffer
+  void Reset() {
+    mPosition = 0;
+    mEnd = 0;
+  }
+
+private:
+  binary * const mStart;
+  const std::size_t mCapacity;
+  const std::uint64_t mBase; ///< file position of mStart
+  std::uint64_t mPosition{0};
+  std::uint64_t mEnd{0}; ///< end of the data written, may be past the buffer
+};
+
+} // namespace libebml
+
+#endif // LIBEBML_MEMWRITEIOCALLBACK_H
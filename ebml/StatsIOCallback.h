@@ -0,0 +1,80 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \brief IOCallback counting the I/O done on another IOCallback
+*/
+#ifndef LIBEBML_STATSIOCALLBACK_H
+#define LIBEBML_STATSIOCALLBACK_H
+
+#include "IOCallback.h"
+
+#include <array>
+#include <chrono>
+
+namespace libebml {
+
+/*!
+  \brief snapshot of the I/O done through a StatsIOCallback
+*/
+struct EBML_DLL_API IOStatistics {
+  /// number of seek distance ranges, each 16 times larger than the previous one
+  static constexpr std::size_t SeekBuckets = 12;
+
+  std::uint64_t Reads{0};
+  std::uint64_t BytesRead{0};
+  std::uint64_t ShortReads{0};   ///< reads returning less than requested
+  std::uint64_t Writes{0};
+  std::uint64_t BytesWritten{0};
+  std::uint64_t Seeks{0};
+  std::uint64_t NoOpSeeks{0};     ///< seeks to the current position
+  std::uint64_t BackwardSeeks{0};
+  std::uint64_t SeekDistance{0};  ///< total distance covered by the seeks
+  /// bucket n counts the seeks moving less than 16^(n+1) octets, the last bucket counts all the farther ones
+  std::array<std::uint64_t, SeekBuckets> SeekHistogram{};
+
+  std::chrono::nanoseconds ReadTime{0};
+  std::chrono::nanoseconds WriteTime{0};
+  std::chrono::nanoseconds SeekTime{0};
+
+  static std::size_t SeekBucket(std::uint64_t Distance);
+};
+
+/*!
+  \class StatsIOCallback
+  \brief forward all I/O to another IOCallback and count it
+
+  The wrapped IOCallback is not owned and must outlive this object.
+  It should not be used directly while wrapped, as the position is tracked
+  to measure the seek distances without extra calls. Seeks within the data
+  already read or written are assumed to land at the requested position. The
+  position of the wrapped IOCallback is queried, outside of the measured time,
+  after seeks from the end and seeks outside of that data, which may be clamped.
+*/
+class EBML_DLL_API StatsIOCallback : public IOCallback {
+public:
+  explicit StatsIOCallback(IOCallback & IO);
+  ~StatsIOCallback() override = default;
+  StatsIOCallback(const StatsIOCallback&) = delete;
+  StatsIOCallback& operator=(const StatsIOCallback&) = delete;
+
+  std::size_t read(void *Buffer, std::size_t Size) override;
+  void setFilePointer(std::int64_t Offset, seek_mode Mode = seek_beginning) override;
+  std::size_t write(const void *Buffer, std::size_t Size) override;
+  std::uint64_t getFilePointer() override { return mPosition; }
+  void close() override { mIO.close(); }
+
+  const IOStatistics & GetStatistics() const { return mStats; }
+  void ResetStatistics() { mStats = IOStatistics{}; }
+
+private:
+  IOCallback & mIO;
+  std::uint64_t mPosition;
+  std::uint64_t mEnd; ///< end of the data known to exist in the wrapped IOCallback
+  IOStatistics mStats;
+};
+
+} // namespace libebml
+
+#endif // LIBEBML_STATSIOCALLBACK_H
@@ -49,6 +49,10 @@ class EBML_DLL_API StdIOCallback:public IOCallback
   // If an error occurs, an exception should be thrown.
   std::uint64_t getFilePointer() override;
 
+  // Between two files on Linux the data are copied by the kernel with
+  // copy_file_range() or sendfile().
+  std::uint64_t CopyFrom(IOCallback & Source, std::uint64_t Position, std::uint64_t Size) override;
+
   // The close callback flushes the file buffers to disk and closes the file. When using the stdio
   // library, this is equivalent to calling fclose. When the close is not successful, an exception
   // should be thrown.
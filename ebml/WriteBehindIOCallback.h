@@ -0,0 +1,100 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \brief IOCallback writing to another IOCallback in a background thread
+*/
+#ifndef LIBEBML_WRITEBEHINDIOCALLBACK_H
+#define LIBEBML_WRITEBEHINDIOCALLBACK_H
+
+#include "IOCallback.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace libebml {
+
+/*!
+  \class WriteBehindIOCallback
+  \brief accumulate the writes in buffers written to another IOCallback by a dedicated thread
+
+  The writes are copied in a buffer that is handed to the writer thread when
+  it's full or when the position moves outside of it. Writing before the end
+  of the buffer being filled, as done by EbmlElement::OverwriteHead(), patches it
+  in place. Writing elsewhere starts another buffer written at its position
+  after the previous ones, so the result is the same as writing directly.
+  When all the buffers are waiting to be written, writing blocks until one is
+  available.
+
+  Reading waits until all the buffers are written. Errors of the writer thread
+  are thrown by the next call.
+
+  The wrapped IOCallback is not owned and must outlive this object. It's only
+  used by the writer thread until this object is destroyed.
+  \note this object should only be used by one thread
+*/
+class EBML_DLL_API WriteBehindIOCallback : public IOCallback {
+public:
+  static constexpr std::size_t DefaultBufferSize = 4 * 1024 * 1024;
+  static constexpr std::size_t DefaultBufferCount = 3;
+
+  explicit WriteBehindIOCallback(IOCallback & IO, std::size_t BufferSize = DefaultBufferSize, std::size_t BufferCount = DefaultBufferCount);
+  ~WriteBehindIOCallback() override;
+  WriteBehindIOCallback(const WriteBehindIOCallback&) = delete;
+  WriteBehindIOCallback& operator=(const WriteBehindIOCallback&) = delete;
+
+  std::size_t read(void *Buffer, std::size_t Size) override;
+  void setFilePointer(std::int64_t Offset, seek_mode Mode = seek_beginning) override;
+  std::size_t write(const void *Buffer, std::size_t Size) override;
+  std::uint64_t getFilePointer() override { return mPosition; }
+  /// write all the buffers and close the wrapped IOCallback
+  void close() override;
+
+  /// wait until all the data written so far are written to the wrapped IOCallback
+  void Flush();
+
+  /// number of times writing waited for a buffer to be available
+  std::uint64_t GetStalls() const { return mStalls; }
+
+private:
+  struct Buffer {
+    std::uint64_t Position{0};
+    std::size_t Used{0};
+    std::unique_ptr<binary[]> Data;
+  };
+
+  std::unique_ptr<Buffer> GetBuffer(std::uint64_t Position);
+  void Submit();
+  void CheckError();
+  void WriterThread();
+
+  IOCallback & mIO;
+  const std::size_t mBufferSize;
+  const std::size_t mBufferCount;
+  std::uint64_t mPosition;
+  std::uint64_t mSize;
+  std::uint64_t mStalls{0};
+  std::unique_ptr<Buffer> mCurrent; ///< the buffer being filled
+
+  std::mutex mMutex;
+  std::condition_variable mWork; ///< buffers waiting to be written or stopping
+  std::condition_variable mDone; ///< a buffer has been written
+  std::deque<std::unique_ptr<Buffer>> mQueue;
+  std::vector<std::unique_ptr<Buffer>> mFree;
+  std::size_t mAllocated{0};
+  std::uint64_t mWriterPosition; ///< position of the wrapped IOCallback
+  bool mWriting{false};
+  bool mStop{false};
+  std::exception_ptr mError;
+  std::thread mWriter;
+};
+
+} // namespace libebml
+
+#endif // LIBEBML_WRITEBEHINDIOCALLBACK_H
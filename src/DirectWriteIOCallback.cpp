@@ -0,0 +1,280 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \author Steve Lhomme     <robux4 @ users.sf.net>
+*/
+#include "ebml/DirectWriteIOCallback.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ios>
+#include <new>
+#include <sstream>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace libebml {
+
+static std::size_t AlignUp(std::size_t Size, std::size_t Alignment)
+{
+  return (Size + Alignment - 1) / Alignment * Alignment;
+}
+
+static void ThrowError(const char *Operation)
+{
+  const int Error = errno;
+  std::stringstream Msg;
+  Msg << "Can't " << Operation << " the direct file";
+  throw std::ios_base::failure(Msg.str(), std::error_code{Error, std::system_category()});
+}
+
+void DirectWriteIOCallback::AlignedFree::operator()(binary *Buffer) const
+{
+  free(Buffer);
+}
+
+DirectWriteIOCallback::AlignedBuffer DirectWriteIOCallback::AllocAligned(std::size_t Size)
+{
+  void *Buffer = nullptr;
+  if (posix_memalign(&Buffer, Alignment, Size) != 0)
+    throw std::bad_alloc();
+  return AlignedBuffer(static_cast<binary *>(Buffer));
+}
+
+DirectWriteIOCallback::DirectWriteIOCallback(const char *Path, std::size_t BufferSize)
+  :mBufferSize(AlignUp(std::max(BufferSize, Alignment), Alignment))
+{
+  int Flags = O_RDWR | O_CREAT | O_TRUNC;
+#if defined(O_CLOEXEC)
+  Flags |= O_CLOEXEC;
+#endif
+#if defined(O_DIRECT)
+  mFile = ::open(Path, Flags | O_DIRECT, 0666);
+  if (mFile >= 0)
+    mDirect = true;
+  else if (errno != EINVAL)
+    ThrowError("open");
+#endif
+  if (mFile < 0) {
+    // the filesystem doesn't support direct I/O
+    mFile = ::open(Path, Flags, 0666);
+    if (mFile < 0)
+      ThrowError("open");
+  }
+#if defined(F_NOCACHE)
+  if (!mDirect && fcntl(mFile, F_NOCACHE, 1) != -1)
+    mDirect = true;
+#endif
+
+  mBuffer = AllocAligned(mBufferSize);
+  mBlocks = AllocAligned(mBufferSize);
+}
+
+DirectWriteIOCallback::~DirectWriteIOCallback()
+{
+  try {
+    close();
+  } catch (...) {
+  }
+}
+
+void DirectWriteIOCallback::WriteBlocks(const binary *Buffer, std::size_t Size, std::uint64_t Position)
+{
+  while (Size != 0) {
+    const auto Written = ::pwrite(mFile, Buffer, Size, static_cast<off_t>(Position));
+    if (Written < 0) {
+      if (errno == EINTR)
+        continue;
+#if defined(O_DIRECT)
+      // some filesystems accept O_DIRECT on open but not on writes
+      if (errno == EINVAL && mDirect) {
+        const int Flags = fcntl(mFile, F_GETFL);
+        if (Flags != -1 && fcntl(mFile, F_SETFL, Flags & ~O_DIRECT) != -1) {
+          mDirect = false;
+          continue;
+        }
+      }
+#endif
+      ThrowError("write");
+    }
+    Buffer += Written;
+    Size -= static_cast<std::size_t>(Written);
+    Position += static_cast<std::uint64_t>(Written);
+  }
+}
+
+void DirectWriteIOCallback::ReadBlocks(binary *Buffer, std::size_t Size, std::uint64_t Position)
+{
+  while (Size != 0) {
+    const auto Read = ::pread(mFile, Buffer, Size, static_cast<off_t>(Position));
+    if (Read < 0) {
+      if (errno == EINTR)
+        continue;
+      ThrowError("read");
+    }
+    if (Read == 0) {
+      // past the end of the file written so far
+      memset(Buffer, 0, Size);
+      return;
+    }
+    Buffer += Read;
+    Size -= static_cast<std::size_t>(Read);
+    Position += static_cast<std::uint64_t>(Read);
+  }
+}
+
+void DirectWriteIOCallback::WriteBuffer()
+{
+  WriteBlocks(mBuffer.get(), mBufferSize, mBufferStart);
+  mBufferStart += mBufferSize;
+  mBufferUsed = 0;
+}
+
+void DirectWriteIOCallback::PatchWritten(std::uint64_t Position, const binary *Data, std::size_t Size)
+{
+  while (Size != 0) {
+    const std::uint64_t BlockStart = Position / Alignment * Alignment;
+    const auto Offset = static_cast<std::size_t>(Position - BlockStart);
+    // the buffer starts on a block boundary
+    const auto Blocks = static_cast<std::size_t>(std::min<std::uint64_t>(
+      std::min(AlignUp(Offset + Size, Alignment), mBufferSize), mBufferStart - BlockStart));
+    const auto Patched = std::min(Size, Blocks - Offset);
+
+    ReadBlocks(mBlocks.get(), Blocks, BlockStart);
+    memcpy(mBlocks.get() + Offset, Data, Patched);
+    WriteBlocks(mBlocks.get(), Blocks, BlockStart);
+
+    Data += Patched;
+    Size -= Patched;
+    Position += Patched;
+  }
+}
+
+void DirectWriteIOCallback::ReadWritten(std::uint64_t Position, binary *Data, std::size_t Size)
+{
+  while (Size != 0) {
+    const std::uint64_t BlockStart = Position / Alignment * Alignment;
+    const auto Offset = static_cast<std::size_t>(Position - BlockStart);
+    const auto Blocks = static_cast<std::size_t>(std::min<std::uint64_t>(
+      std::min(AlignUp(Offset + Size, Alignment), mBufferSize), mBufferStart - BlockStart));
+    const auto Read = std::min(Size, Blocks - Offset);
+
+    ReadBlocks(mBlocks.get(), Blocks, BlockStart);
+    memcpy(Data, mBlocks.get() + Offset, Read);
+
+    Data += Read;
+    Size -= Read;
+    Position += Read;
+  }
+}
+
+std::size_t DirectWriteIOCallback::write(const void *Buffer, std::size_t Size)
+{
+  if (mFile < 0)
+    throw std::ios_base::failure("The direct file is closed");
+
+  // writing after the end fills the gap with zeros
+  while (mPosition > GetSize()) {
+    const auto Gap = static_cast<std::size_t>(std::min<std::uint64_t>(mPosition - GetSize(), mBufferSize - mBufferUsed));
+    memset(mBuffer.get() + mBufferUsed, 0, Gap);
+    mBufferUsed += Gap;
+    if (mBufferUsed == mBufferSize)
+      WriteBuffer();
+  }
+
+  auto Source = static_cast<const binary *>(Buffer);
+  std::size_t Remaining = Size;
+  while (Remaining != 0) {
+    std::size_t Copied;
+    if (mPosition < mBufferStart) {
+      Copied = static_cast<std::size_t>(std::min<std::uint64_t>(Remaining, mBufferStart - mPosition));
+      PatchWritten(mPosition, Source, Copied);
+    } else {
+      const auto Offset = static_cast<std::size_t>(mPosition - mBufferStart);
+      Copied = std::min(Remaining, mBufferSize - Offset);
+      memcpy(mBuffer.get() + Offset, Source, Copied);
+      mBufferUsed = std::max(mBufferUsed, Offset + Copied);
+      if (mBufferUsed == mBufferSize)
+        WriteBuffer();
+    }
+    Source += Copied;
+    Remaining -= Copied;
+    mPosition += Copied;
+  }
+  return Size;
+}
+
+std::size_t DirectWriteIOCallback::read(void *Buffer, std::size_t Size)
+{
+  if (mFile < 0)
+    throw std::ios_base::failure("The direct file is closed");
+  if (mPosition >= GetSize())
+    return 0;
+
+  Size = static_cast<std::size_t>(std::min<std::uint64_t>(Size, GetSize() - mPosition));
+  auto Output = static_cast<binary *>(Buffer);
+  if (mPosition < mBufferStart) {
+    const auto Written = static_cast<std::size_t>(std::min<std::uint64_t>(Size, mBufferStart - mPosition));
+    ReadWritten(mPosition, Output, Written);
+    Output += Written;
+    mPosition += Written;
+  }
+  const auto Buffered = Size - static_cast<std::size_t>(Output - static_cast<binary *>(Buffer));
+  memcpy(Output, mBuffer.get() + (mPosition - mBufferStart), Buffered);
+  mPosition += Buffered;
+  return Size;
+}
+
+void DirectWriteIOCallback::setFilePointer(std::int64_t Offset, seek_mode Mode)
+{
+  switch (Mode) {
+    case seek_beginning:
+      mPosition = Offset;
+      break;
+    case seek_current:
+      mPosition += Offset;
+      break;
+    case seek_end:
+      mPosition = GetSize() + Offset;
+      break;
+  }
+}
+
+void DirectWriteIOCallback::Flush()
+{
+  if (mFile < 0 || mBufferUsed == 0)
+    return;
+
+  // the last block is written padded, the buffer is kept to continue it
+  const auto Padded = AlignUp(mBufferUsed, Alignment);
+  memset(mBuffer.get() + mBufferUsed, 0, Padded - mBufferUsed);
+  WriteBlocks(mBuffer.get(), Padded, mBufferStart);
+  if (::ftruncate(mFile, static_cast<off_t>(GetSize())) != 0)
+    ThrowError("truncate");
+}
+
+void DirectWriteIOCallback::close()
+{
+  if (mFile < 0)
+    return;
+  const int File = mFile;
+  try {
+    Flush();
+  } catch (...) {
+    mFile = -1;
+    ::close(File);
+    throw;
+  }
+  mFile = -1;
+  if (::close(File) != 0)
+    ThrowError("close");
+}
+
+} // namespace libebml
@@ -6,13 +6,40 @@
   \author Steve Lhomme     <robux4 @ users.sf.net>
   \author Julien Coloos  <suiryc @ users.sf.net>
 */
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
 #include <string>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include "ebml/EbmlBinary.h"
 
 namespace libebml {
 
+struct EbmlBinary::DeferredPayload {
+  /// the stream to read the payload from, the caller keeps it valid
+  IOCallback *Source{nullptr};
+  std::uint64_t Position{0};
+  /// the callback producing the payload, used when there's no Source
+  DataSource Producer;
+
+  /// the payload is loaded once, even from several threads
+  std::once_flag Load;
+  /// set once the payload is in Data
+  std::atomic<bool> Loaded{false};
+
+  DeferredPayload() = default;
+  /// a source of the same payload, not loaded yet
+  DeferredPayload(const DeferredPayload & Other)
+    :Source(Other.Source)
+    ,Position(Other.Position)
+    ,Producer(Other.Producer)
+  {}
+};
+
 EbmlBinary::EbmlBinary(const EbmlCallbacks & classInfo)
   :EbmlElement(classInfo, 0, false)
 {}
@@ -20,41 +47,208 @@ EbmlBinary::EbmlBinary(const EbmlCallbacks & classInfo)
 EbmlBinary::EbmlBinary(const EbmlBinary & ElementToClone)
   :EbmlElement(ElementToClone)
 {
-  if (ElementToClone.Data) {
-    Data = static_cast<binary *>(malloc(GetSize()));
+  if (ElementToClone.IsDeferred())
+    Deferred = std::make_unique<DeferredPayload>(*ElementToClone.Deferred);
+  else if (ElementToClone.Data) {
+    Data = AllocData(GetSize());
     if(Data)
       memcpy(Data, ElementToClone.Data, GetSize());
   }
 }
 
+EbmlBinary::EbmlBinary(EbmlBinary && ElementToMove) noexcept
+  :EbmlElement(std::move(ElementToMove))
+  ,Data(ElementToMove.Data)
+  ,Deferred(std::move(ElementToMove.Deferred))
+{
+  if (Data == ElementToMove.InlineData) {
+    Data = InlineData;
+    memcpy(InlineData, ElementToMove.InlineData, GetSize());
+  }
+  ElementToMove.Data = nullptr;
+  ElementToMove.SetSize_(0);
+}
+
+binary *EbmlBinary::AllocData(std::uint64_t DataSize) const
+{
+  if (DataSize <= InlineSize)
+    return InlineData;
+  if (DataSize >= std::numeric_limits<std::size_t>::max())
+    return nullptr;
+  return static_cast<binary *>(malloc(DataSize));
+}
+
 EbmlBinary &
 EbmlBinary::operator=(const EbmlBinary & ElementToClone)
 {
   if (this == &ElementToClone)  // check for self-assigment
     return *this;
 
-  free(Data);
-  if (ElementToClone.Data == nullptr)
-    Data = nullptr;
-  else {
-    Data = static_cast<binary *>(malloc(GetSize()));
+  FreeData();
+  Deferred.reset();
+  if (ElementToClone.IsDeferred())
+    Deferred = std::make_unique<DeferredPayload>(*ElementToClone.Deferred);
+  else if (ElementToClone.Data != nullptr) {
+    Data = AllocData(GetSize());
     if(Data != nullptr)
       memcpy(Data, ElementToClone.Data, GetSize());
   }
   return *this;
 }
 
+EbmlBinary &
+EbmlBinary::operator=(EbmlBinary && ElementToMove) noexcept
+{
+  if (this == &ElementToMove)  // check for self-assigment
+    return *this;
+
+  FreeData();
+  EbmlElement::operator=(std::move(ElementToMove));
+  Data = ElementToMove.Data;
+  Deferred = std::move(ElementToMove.Deferred);
+  if (Data == ElementToMove.InlineData) {
+    Data = InlineData;
+    memcpy(InlineData, ElementToMove.InlineData, GetSize());
+  }
+  ElementToMove.Data = nullptr;
+  ElementToMove.SetSize_(0);
+  return *this;
+}
+
 EbmlBinary::~EbmlBinary() {
-  if(Data)
-    free(Data);
+  FreeData();
+}
+
+EbmlBinary::operator const binary &() const {return *GetBuffer();}
+
+void EbmlBinary::ReadDeferred(binary *Buffer, std::uint64_t Offset, std::size_t Size) const
+{
+  if (Deferred->Source == nullptr) {
+    for (std::size_t Produced = 0; Produced < Size; ) {
+      const auto Read = Deferred->Producer(Offset + Produced, Buffer + Produced, Size - Produced);
+      if (Read == 0)
+        throw std::runtime_error("missing data from the binary source");
+      Produced += Read;
+    }
+    return;
+  }
+
+  auto & Source = *Deferred->Source;
+  const std::uint64_t CurrentPosition = Source.getFilePointer();
+  Source.setFilePointer(Deferred->Position + Offset, seek_beginning);
+  const auto Read = Source.read(Buffer, Size);
+  Source.setFilePointer(CurrentPosition, seek_beginning);
+  if (Read != Size)
+    throw std::runtime_error("EOF reading deferred binary data");
+}
+
+void EbmlBinary::ReadDeferred(binary *Buffer) const
+{
+  ReadDeferred(Buffer, 0, static_cast<std::size_t>(GetSize()));
+}
+
+std::uint64_t EbmlBinary::GetDeferredPosition() const
+{
+  return IsDeferred() ? Deferred->Position : 0;
+}
+
+bool EbmlBinary::IsDeferred() const
+{
+  return Deferred != nullptr && !Deferred->Loaded.load(std::memory_order_acquire);
+}
+
+void EbmlBinary::ResetSources()
+{
+  Deferred.reset();
+}
+
+void EbmlBinary::LoadDeferred() const
+{
+  // a failed load can be tried again
+  std::call_once(Deferred->Load, [this] {
+    binary *Buffer = AllocData(GetSize());
+    if (Buffer == nullptr)
+      throw std::runtime_error("Error allocating data");
+    try {
+      ReadDeferred(Buffer);
+    } catch (...) {
+      if (Buffer != InlineData)
+        free(Buffer);
+      throw;
+    }
+    Data = Buffer;
+    Deferred->Loaded.store(true, std::memory_order_release);
+  });
+}
+
+binary *EbmlBinary::GetBuffer() const
+{
+  if (IsDeferred())
+    LoadDeferred();
+  return Data;
+}
+
+void EbmlBinary::ReadBuffer(binary *Buffer) const
+{
+  if (IsDeferred())
+    ReadDeferred(Buffer);
+  else if (Data != nullptr)
+    memcpy(Buffer, Data, GetSize());
+}
+
+void EbmlBinary::ReadChunks(const DataSink & Sink, std::size_t ChunkSize) const
+{
+  if (ChunkSize == 0)
+    throw std::invalid_argument("empty binary chunks");
+
+  const std::uint64_t Size = GetSize();
+  if (!IsDeferred()) {
+    if (Data == nullptr && Size != 0)
+      throw std::runtime_error("binary data not read");
+    for (std::uint64_t Offset = 0; Offset < Size; Offset += ChunkSize)
+      Sink(Data + Offset, static_cast<std::size_t>(std::min<std::uint64_t>(ChunkSize, Size - Offset)));
+    return;
+  }
+
+  std::vector<binary> Chunk(static_cast<std::size_t>(std::min<std::uint64_t>(ChunkSize, Size)));
+  for (std::uint64_t Offset = 0; Offset < Size; Offset += ChunkSize) {
+    const auto ChunkRead = static_cast<std::size_t>(std::min<std::uint64_t>(ChunkSize, Size - Offset));
+    ReadDeferred(Chunk.data(), Offset, ChunkRead);
+    Sink(Chunk.data(), ChunkRead);
+  }
 }
 
-EbmlBinary::operator const binary &() const {return *Data;}
+void EbmlBinary::SetSource(std::uint64_t Size, DataSource Source)
+{
+  FreeData();
+  ResetSources();
+  Deferred = std::make_unique<DeferredPayload>();
+  Deferred->Producer = std::move(Source);
+  SetSize_(Size);
+  SetValueIsSet();
+}
 
+void EbmlBinary::SetSource(IOCallback & Input, std::uint64_t Position, std::uint64_t Size)
+{
+  FreeData();
+  ResetSources();
+  Deferred = std::make_unique<DeferredPayload>();
+  Deferred->Source = &Input;
+  Deferred->Position = Position;
+  SetSize_(Size);
+  SetValueIsSet();
+}
 
 filepos_t EbmlBinary::RenderData(IOCallback & output, bool /* bForceRender */, const ShouldWrite & /* writeFilter */)
 {
-  output.writeFully(Data,GetSize());
+  if (IsDeferred() && Deferred->Source != nullptr)
+    output.CopyFrom(*Deferred->Source, Deferred->Position, GetSize());
+  else if (IsDeferred())
+    ReadChunks([&output](const binary *Chunk, std::size_t Size) {
+      output.writeFully(Chunk, Size);
+    });
+  else
+    output.writeFully(Data,GetSize());
 
   return GetSize();
 }
@@ -72,10 +266,8 @@ filepos_t EbmlBinary::UpdateSize(const ShouldWrite & writeFilter, bool /* bForce
 
 filepos_t EbmlBinary::ReadData(IOCallback & input, ScopeMode ReadFully)
 {
-  if (Data != nullptr) {
-    free(Data);
-    Data = nullptr;
-  }
+  FreeData();
+  ResetSources();
 
   if (ReadFully == SCOPE_NO_DATA) {
     return GetSize();
@@ -86,7 +278,16 @@ filepos_t EbmlBinary::ReadData(IOCallback & input, ScopeMode ReadFully)
     return 0;
   }
 
-  Data = (GetSize() < std::numeric_limits<std::size_t>::max()) ? static_cast<binary *>(malloc(GetSize())) : nullptr;
+  if (ReadFully == SCOPE_DEFERRED_DATA) {
+    Deferred = std::make_unique<DeferredPayload>();
+    Deferred->Source = &input;
+    Deferred->Position = input.getFilePointer();
+    input.setFilePointer(GetSize(), seek_current);
+    SetValueIsSet();
+    return GetSize();
+  }
+
+  Data = AllocData(GetSize());
   if (Data == nullptr)
     throw std::runtime_error("Error allocating data");
   SetValueIsSet();
@@ -95,7 +296,19 @@ filepos_t EbmlBinary::ReadData(IOCallback & input, ScopeMode ReadFully)
 
 bool EbmlBinary::operator==(const EbmlBinary & ElementToCompare) const
 {
-  return ((GetSize() == ElementToCompare.GetSize()) && (GetSize() == 0 || !memcmp(Data, ElementToCompare.Data, GetSize())));
+  if (GetSize() != ElementToCompare.GetSize())
+    return false;
+  if (GetSize() == 0)
+    return true;
+  if (!IsDeferred() && !ElementToCompare.IsDeferred())
+    return !memcmp(Data, ElementToCompare.Data, GetSize());
+
+  // deferred payloads are compared without loading them in the elements
+  std::vector<binary> Payload(static_cast<std::size_t>(GetSize()));
+  std::vector<binary> PayloadToCompare(Payload.size());
+  ReadBuffer(Payload.data());
+  ElementToCompare.ReadBuffer(PayloadToCompare.data());
+  return Payload == PayloadToCompare;
 }
 
 } // namespace libebml
@@ -14,6 +14,8 @@
 #include <new>
 
 #include "ebml/EbmlElement.h"
+#include "ebml/EbmlMaster.h"
+#include "ebml/EbmlStats.h"
 #include "ebml/EbmlStream.h"
 #include "ebml/EbmlVoid.h"
 #include "ebml/EbmlDummy.h"
@@ -121,17 +123,27 @@ std::uint64_t ReadCodedSizeValue(const binary * InBuffer, std::uint32_t & Buffer
 EbmlElement::EbmlElement(const EbmlCallbacks & classInfo, std::uint64_t aDefaultSize, bool bValueSet)
   : ClassInfo(classInfo)
   , DefaultSize(aDefaultSize)
-  , bValueIsSet(bValueSet)
+  , Flags(FlagSizeIsFinite | (bValueSet ? FlagValueIsSet : 0))
 {
   Size = DefaultSize;
 }
 
+EbmlElement & EbmlElement::operator=(EbmlElement && ElementToMove) noexcept
+{
+  // the class information is not moved, it's the same for both elements
+  Size = ElementToMove.Size;
+  DefaultSize = ElementToMove.DefaultSize;
+  ElementPosition = ElementToMove.ElementPosition;
+  Flags = ElementToMove.Flags;
+  return *this;
+}
+
 /*!
   \todo replace the new RawElement with the appropriate class (when known)
 */
 EbmlElement * EbmlElement::FindNextID(IOCallback & DataStream, const EbmlCallbacks & ClassInfos, std::uint64_t MaxDataSize)
 {
-  std::array<binary, 4> PossibleId;
+  std::array<binary, 4> PossibleId{};
   int PossibleID_Length = 0;
   std::array<binary, 8> PossibleSize; // we don't support size stored in more than 64 bits
   std::uint32_t PossibleSizeLength = 0;
@@ -140,7 +152,7 @@ EbmlElement * EbmlElement::FindNextID(IOCallback & DataStream, const EbmlCallbac
   bool bElementFound = false;
 
   binary BitMask;
-  std::uint64_t aElementPosition = 0, aSizePosition = 0;
+  std::uint64_t aElementPosition = 0;
   while (!bElementFound) {
     // read ID
     aElementPosition = DataStream.getFilePointer();
@@ -169,7 +181,6 @@ EbmlElement * EbmlElement::FindNextID(IOCallback & DataStream, const EbmlCallbac
       return nullptr;
 
     // read the data size
-    aSizePosition = DataStream.getFilePointer();
     std::uint32_t _SizeLength;
     do {
       if (PossibleSizeLength >= 8)
@@ -184,17 +195,17 @@ EbmlElement * EbmlElement::FindNextID(IOCallback & DataStream, const EbmlCallbac
   }
 
   auto Result = [&]() -> EbmlElement * {
-    auto pID = EbmlId(EbmlId::FromBuffer(PossibleId.data(), PossibleID_Length));
-    if (pID != EBML_INFO_ID(ClassInfos)) {
+    if (!EBML_INFO_ID(ClassInfos).Matches(PossibleId.data())) {
       if (SizeFound == SizeUnknown)
         return nullptr;
-      return new EbmlDummy(pID);
+      return new EbmlDummy(EbmlId(EbmlId::FromEncoded(PossibleId.data(), PossibleID_Length)));
     }
     if (SizeFound != SizeUnknown && MaxDataSize < SizeFound)
       return nullptr;
     // check if the size is not all 1s
     if (SizeFound == SizeUnknown && !ClassInfos.CanHaveInfiniteSize())
       return nullptr;
+    const EbmlMaster::CreateForReading ReadingScope;
     return &EBML_INFO_CREATE(ClassInfos);
   }();
 
@@ -212,7 +223,6 @@ EbmlElement * EbmlElement::FindNextID(IOCallback & DataStream, const EbmlCallbac
 
   Result->SetSizeInfinite(SizeFound == SizeUnknown);
   Result->ElementPosition = aElementPosition;
-  Result->SizePosition = aSizePosition;
 
   return Result;
 }
@@ -228,7 +238,7 @@ EbmlElement * EbmlElement::FindNextElement(IOCallback & DataStream, const EbmlSe
                                            std::uint64_t MaxDataSize, bool AllowDummyElt, unsigned int MaxLowerLevel)
 {
   int PossibleID_Length = 0;
-  std::array<binary, 16> PossibleIdNSize;
+  std::array<binary, 16> PossibleIdNSize{};
   int PossibleSizeLength;
   std::uint64_t SizeUnknown;
   int ReadIndex = 0; // trick for the algo, start index at 0
@@ -264,6 +274,7 @@ EbmlElement * EbmlElement::FindNextElement(IOCallback & DataStream, const EbmlSe
         // shift left the read octets
         memmove(PossibleIdNSize.data(), &PossibleIdNSize[1], --ReadIndex);
         IdStart++;
+        EBML_STATS_ADD(ResyncBytes, 1);
       }
 
       if (MaxDataSize <= ReadSize)
@@ -309,7 +320,7 @@ EbmlElement * EbmlElement::FindNextElement(IOCallback & DataStream, const EbmlSe
 
     if (bFound) {
       // find the element in the context and use the correct creator
-      const auto PossibleID = EbmlId(EbmlId::FromBuffer(PossibleIdNSize.data(), PossibleID_Length));
+      const auto PossibleID = EbmlId(EbmlId::FromEncoded(PossibleIdNSize.data(), PossibleID_Length));
       EbmlElement * Result = CreateElementUsingContext(PossibleID, Context, UpperLevel, false, SizeFound == SizeUnknown, AllowDummyElt, MaxLowerLevel);
       ///< \todo continue is misplaced
       if (Result != nullptr) {
@@ -325,9 +336,8 @@ EbmlElement * EbmlElement::FindNextElement(IOCallback & DataStream, const EbmlSe
           if (Result->SizeIsValid(SizeFound) && (SizeFound == SizeUnknown || UpperLevel > 0 || MaxDataSize == 0 ||
                                          MaxDataSize >= (IdStart + PossibleID_Length + _SizeLength + SizeFound))) {
             Result->ElementPosition = ParseStart + IdStart;
-            Result->SizePosition = Result->ElementPosition + PossibleID_Length;
             // place the file at the beggining of the data
-            DataStream.setFilePointer(Result->SizePosition + _SizeLength);
+            DataStream.setFilePointer(Result->GetSizePosition() + _SizeLength);
             return Result;
           }
         }
@@ -339,6 +349,7 @@ EbmlElement * EbmlElement::FindNextElement(IOCallback & DataStream, const EbmlSe
     ReadIndex = SizeIdx - 1;
     memmove(PossibleIdNSize.data(), &PossibleIdNSize[1], ReadIndex);
     IdStart++;
+    EBML_STATS_ADD(ResyncBytes, 1);
     UpperLevel = UpperLevel_original;
   } while ( MaxDataSize >= ReadSize );
 
@@ -351,10 +362,9 @@ EbmlElement * EbmlElement::FindNextElement(IOCallback & DataStream, const EbmlSe
 EbmlElement * EbmlElement::SkipData(EbmlStream & DataStream, const EbmlSemanticContext & Context, EbmlElement * TestReadElt, bool AllowDummyElt)
 {
   EbmlElement * Result = nullptr;
-  if (bSizeIsFinite) {
+  if (IsFiniteSize()) {
     assert(TestReadElt == nullptr);
-    assert(ElementPosition < SizePosition);
-    DataStream.I_O().setFilePointer(SizePosition + CodedSizeLength(Size, SizeLength, bSizeIsFinite) + Size, seek_beginning);
+    DataStream.I_O().setFilePointer(GetEndPosition(), seek_beginning);
     //    DataStream.I_O().setFilePointer(Size, seek_current);
   } else {
     /////////////////////////////////////////////////
@@ -414,6 +424,7 @@ EbmlElement *EbmlElement::CreateElementUsingContext(const EbmlId & aID, const Eb
                                                     bool bAllowDummy, unsigned int MaxLowerLevel)
 {
   EbmlElement *Result = nullptr;
+  const EbmlMaster::CreateForReading ReadingScope;
 
   // elements at the current level
   if (EBML_CTX_SIZE(Context))
@@ -434,6 +445,7 @@ EbmlElement *EbmlElement::CreateElementUsingContext(const EbmlId & aID, const Eb
   assert(Context.GetGlobalContext != nullptr); // global should always exist, at least the EBML ones
   const auto& tstContext = Context.GetGlobalContext();
   if (tstContext != Context) {
+    EBML_STATS_ADD(GlobalContextLookups, 1);
     LowLevel--;
     MaxLowerLevel--;
     // recursive is good, but be carefull...
@@ -460,6 +472,7 @@ EbmlElement *EbmlElement::CreateElementUsingContext(const EbmlId & aID, const Eb
 
   // check wether it's not part of an upper context
   if (EBML_CTX_PARENT(Context) != nullptr) {
+    EBML_STATS_ADD(ParentContextLookups, 1);
     LowLevel++;
     MaxLowerLevel++;
     return CreateElementUsingContext(aID, *EBML_CTX_PARENT(Context), LowLevel, IsGlobalContext, AsInfiniteSize, bAllowDummy, MaxLowerLevel);
@@ -468,6 +481,7 @@ EbmlElement *EbmlElement::CreateElementUsingContext(const EbmlId & aID, const Eb
   if (!IsGlobalContext && bAllowDummy && !AsInfiniteSize) {
     LowLevel = 0;
     Result = new (std::nothrow) EbmlDummy(aID);
+    EBML_STATS_ADD(DummyElements, 1);
   }
 
   return Result;
@@ -478,11 +492,12 @@ EbmlElement *EbmlElement::CreateElementUsingContext(const EbmlId & aID, const Eb
 */
 filepos_t EbmlElement::Render(IOCallback & output, const ShouldWrite& writeFilter, bool bKeepPosition, bool bForceRender)
 {
-  assert(bValueIsSet || CanWrite(writeFilter)); // an element is been rendered without a value set !!!
+  assert(ValueIsSet() || CanWrite(writeFilter)); // an element is been rendered without a value set !!!
   // it may be a mandatory element without a default value
   if (!CanWrite(writeFilter)) {
     return 0;
   }
+  EBML_STATS_TRACE(Render, *this);
 #if !defined(NDEBUG)
   filepos_t SupposedSize = UpdateSize(writeFilter, bForceRender);
 #endif // !NDEBUG
@@ -513,17 +528,17 @@ filepos_t EbmlElement::MakeRenderHead(IOCallback & output, bool bKeepPosition)
   std::array<binary, 4 + 8> FinalHead; // Class D + 64 bits coded size
   std::size_t FinalHeadSize;
 
-  FinalHeadSize = EBML_ID_LENGTH(static_cast<const EbmlId&>(*this));
-  EbmlId(*this).Fill(FinalHead.data());
+  const auto & Id = static_cast<const EbmlId&>(*this);
+  FinalHeadSize = EBML_ID_LENGTH(Id);
+  Id.FillFixed(FinalHead.data()); // the size overwrites the padding
 
-  const unsigned int CodedSize = CodedSizeLength(Size, SizeLength, bSizeIsFinite);
+  const unsigned int CodedSize = CodedSizeLength(Size, GetSizeLength(), IsFiniteSize());
   CodedValueLength(Size, CodedSize, &FinalHead.at(FinalHeadSize));
   FinalHeadSize += CodedSize;
 
   output.writeFully(FinalHead.data(), FinalHeadSize);
   if (!bKeepPosition) {
     ElementPosition = output.getFilePointer() - FinalHeadSize;
-    SizePosition = ElementPosition + FinalHeadSize;
   }
 
   return FinalHeadSize;
@@ -536,6 +551,31 @@ std::uint64_t EbmlElement::ElementSize(const ShouldWrite& writeFilter) const
   return Size + HeadSize();
 }
 
+void EbmlElement::AddMemoryUsage(EbmlMemoryReport & Report) const
+{
+  Report.Add(*this, ObjectSize(), 0);
+}
+
+EbmlMemoryReport EbmlElement::GetMemoryReport() const
+{
+  EbmlMemoryReport Report;
+  AddMemoryUsage(Report);
+  return Report;
+}
+
+void EbmlMemoryReport::Add(const EbmlElement & Element, std::size_t Object, std::size_t Payload, std::size_t Containers)
+{
+  auto & Usage = PerId[EbmlId(Element).GetValue()];
+  if (Usage.Name == nullptr)
+    Usage.Name = Element.DebugName();
+  for (auto * Sum : { static_cast<EbmlMemoryUsage *>(&Usage), &Total }) {
+    Sum->Elements++;
+    Sum->Objects += Object;
+    Sum->Payload += Payload;
+    Sum->Containers += Containers;
+  }
+}
+
 bool EbmlElement::IsSmallerThan(const EbmlElement *Cmp) const
 {
   return EbmlId(*this) == EbmlId(*Cmp);
@@ -551,22 +591,23 @@ bool EbmlElement::CompareElements(const EbmlElement *A, const EbmlElement *B)
 
 void EbmlElement::Read(EbmlStream & inDataStream, const EbmlSemanticContext & /* Context */, int & /* UpperEltFound */, EbmlElement * & /* FoundElt */, bool /* AllowDummyElt */, ScopeMode ReadFully)
 {
+  EBML_STATS_TRACE(Read, *this);
   ReadData(inDataStream.I_O(), ReadFully);
 }
 
 bool EbmlElement::ForceSize(std::uint64_t NewSize)
 {
-  if (bSizeIsFinite) {
+  if (IsFiniteSize()) {
     return false;
   }
 
-  const auto OldSizeLen = CodedSizeLength(Size, SizeLength, bSizeIsFinite);
+  const auto OldSizeLen = CodedSizeLength(Size, GetSizeLength(), false);
   const std::uint64_t OldSize = Size;
 
   Size = NewSize;
 
-  if (CodedSizeLength(Size, SizeLength, bSizeIsFinite) == OldSizeLen) {
-    bSizeIsFinite = true;
+  if (CodedSizeLength(Size, GetSizeLength(), false) == OldSizeLen) {
+    SetFlag(FlagSizeIsFinite, true);
     return true;
   }
   Size = OldSize;
@@ -0,0 +1,424 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \author Steve Lhomme     <robux4 @ users.sf.net>
+*/
+#include "ebml/EbmlIndex.h"
+#include "ebml/EbmlCrc32.h"
+#include "ebml/EbmlEndian.h"
+#include "ebml/EbmlMaster.h"
+
+#include <algorithm>
+#include <array>
+#include <future>
+#include <limits>
+#include <memory>
+
+namespace libebml {
+
+static constexpr std::array<binary, 7> IndexMagic = { 'E', 'B', 'M', 'L', 'I', 'D', 'X' };
+static constexpr binary EntryFlagSizeIsFinite = 0x01;
+static constexpr binary IndexFlagTruncated = 0x01;
+/// entries read at once from a sidecar, the count in the header can't be trusted
+static constexpr std::size_t ReadChunkEntries = 2048;
+
+namespace {
+
+struct IndexBuilder {
+  IOCallback & File;
+  std::vector<EbmlIndexEntry> & Entries;
+  unsigned int MaxDepth;
+  std::uint64_t StopPosition; ///< don't record top level elements starting at or after this position
+  bool Stopped{false};
+
+  /*!
+    \brief record the elements of one level
+    \return an element found that belongs to an upper level, with \a UpperLevel relative to this level
+  */
+  EbmlElement * Scan(const EbmlSemanticContext & Context, std::uint32_t Parent, unsigned int Depth,
+                     bool FiniteEnd, std::uint64_t EndPosition, int & UpperLevel)
+  {
+    EbmlElement * Pending = nullptr;
+    while (!Stopped) {
+      std::unique_ptr<EbmlElement> Elt;
+      int Upper = 0;
+      if (Pending != nullptr) {
+        Elt.reset(Pending);
+        Pending = nullptr;
+        if (Depth == 0 && Elt->GetElementPosition() >= StopPosition) {
+          File.setFilePointer(Elt->GetElementPosition());
+          return nullptr;
+        }
+      } else {
+        const auto Position = File.getFilePointer();
+        if (FiniteEnd && Position >= EndPosition)
+          return nullptr;
+        if (Depth == 0 && Position >= StopPosition)
+          return nullptr;
+        const auto MaxDataSize = FiniteEnd ? EndPosition - Position : std::numeric_limits<std::uint64_t>::max();
+        Elt.reset(EbmlElement::FindNextElement(File, Context, Upper, MaxDataSize, true));
+        if (Elt == nullptr)
+          return nullptr;
+        if (Upper > 0) {
+          UpperLevel = Upper;
+          return Elt.release();
+        }
+        // Upper < 0 for global elements, they belong to this level
+      }
+
+      const auto Index = static_cast<std::uint32_t>(Entries.size());
+      EbmlIndexEntry Entry;
+      Entry.Position = Elt->GetElementPosition();
+      Entry.DataSize = Elt->IsFiniteSize() ? Elt->GetSize() : 0;
+      Entry.Id = EbmlId(*Elt).GetValue();
+      Entry.Parent = Parent;
+      Entry.Depth = static_cast<std::uint8_t>(Depth);
+      Entry.HeadSize = static_cast<std::uint8_t>(Elt->GetDataStart() - Elt->GetElementPosition());
+      Entry.SizeIsFinite = Elt->IsFiniteSize();
+      Entries.push_back(Entry);
+
+      if (Elt->IsMaster() && Depth < MaxDepth) {
+        int SubUpper = 0;
+        EbmlElement * Found = Scan(EBML_CONTEXT(Elt.get()), Index, Depth + 1,
+                                   Elt->IsFiniteSize(), Elt->IsFiniteSize() ? Elt->GetEndPosition() : 0, SubUpper);
+        if (Found != nullptr) {
+          // the child level ended on an element of this level or above
+          if (SubUpper > 1) {
+            UpperLevel = SubUpper - 1;
+            return Found;
+          }
+          Pending = Found;
+          continue;
+        }
+        if (Elt->IsFiniteSize())
+          File.setFilePointer(Elt->GetEndPosition());
+        else
+          // the end of the file was reached inside the element
+          return nullptr;
+      } else if (Elt->IsFiniteSize()) {
+        File.setFilePointer(Elt->GetEndPosition());
+      } else {
+        // we can't tell where the next element is without parsing this one
+        Stopped = true;
+      }
+    }
+    return nullptr;
+  }
+};
+
+struct RangeScan {
+  std::uint64_t Start;
+  std::uint64_t End{0};
+  bool Stopped{false};
+  bool Truncated{false}; ///< stopped on an element with an unknown size
+  std::vector<EbmlIndexEntry> Entries;
+};
+
+/*!
+  \brief record the elements between \a Start and the first element starting at or after \a Stop
+*/
+void ScanRange(IOCallback & File, const EbmlSemanticContext & Context, unsigned int MaxDepth,
+               std::uint64_t Stop, std::uint64_t End, RangeScan & Range)
+{
+  File.setFilePointer(Range.Start);
+  IndexBuilder Builder{File, Range.Entries, MaxDepth, Stop};
+  int UpperLevel = 0;
+  std::unique_ptr<EbmlElement> Upper(Builder.Scan(Context, EbmlIndex::NoParent, 0, true, End, UpperLevel));
+  if (Upper != nullptr) {
+    // the element of the context ended
+    Range.End = Upper->GetElementPosition();
+    Range.Stopped = true;
+  } else {
+    Range.End = std::min(File.getFilePointer(), End);
+    Range.Stopped = Builder.Stopped;
+    Range.Truncated = Builder.Stopped;
+  }
+}
+
+/*!
+  \brief find the first element of \a Context starting between \a From and \a RangeEnd
+  \return \a RangeEnd if there is none
+
+  A candidate is only used when it is followed by another element of the
+  context or ends at \a End, to avoid resynchronizing on data looking like
+  an element head.
+*/
+std::uint64_t Resync(IOCallback & File, const EbmlSemanticContext & Context,
+                     std::uint64_t From, std::uint64_t RangeEnd, std::uint64_t End)
+{
+  auto Position = From;
+  while (Position < RangeEnd) {
+    File.setFilePointer(Position);
+    int UpperLevel = 0;
+    std::unique_ptr<EbmlElement> Candidate(EbmlElement::FindNextElement(File, Context, UpperLevel, End - Position, false));
+    if (Candidate == nullptr)
+      break;
+    const auto CandidatePosition = Candidate->GetElementPosition();
+    if (CandidatePosition >= RangeEnd)
+      break;
+    if (UpperLevel == 0 && Candidate->IsFiniteSize()) {
+      const auto CandidateEnd = Candidate->GetEndPosition();
+      if (CandidateEnd == End)
+        return CandidatePosition;
+      if (CandidateEnd < End) {
+        File.setFilePointer(CandidateEnd);
+        UpperLevel = 0;
+        std::unique_ptr<EbmlElement> Next(EbmlElement::FindNextElement(File, Context, UpperLevel, End - CandidateEnd, false));
+        if (Next != nullptr && UpperLevel <= 0 && Next->GetElementPosition() == CandidateEnd)
+          return CandidatePosition;
+      }
+    }
+    Position = CandidatePosition + 1;
+  }
+  return RangeEnd;
+}
+
+} // namespace
+
+EbmlIndex::FileIdentity EbmlIndex::Identify(IOCallback & File)
+{
+  FileIdentity Result;
+  File.setFilePointer(0, seek_end);
+  Result.Size = File.getFilePointer();
+  File.setFilePointer(0);
+
+  std::array<binary, 4096> Buffer;
+  EbmlCrc32 Crc;
+  std::uint64_t Remaining = std::min<std::uint64_t>(Result.Size, IdentitySize);
+  while (Remaining != 0) {
+    const auto Read = File.read(Buffer.data(), std::min<std::size_t>(Buffer.size(), Remaining));
+    if (Read == 0)
+      break;
+    Crc.Update(Buffer.data(), static_cast<std::uint32_t>(Read));
+    Remaining -= Read;
+  }
+  Crc.Finalize();
+  Result.StartCrc = Crc.GetCrc32();
+  return Result;
+}
+
+EbmlIndex EbmlIndex::Build(IOCallback & File, const EbmlSemanticContext & Context, unsigned int MaxDepth)
+{
+  EbmlIndex Result;
+  Result.Identity = Identify(File);
+  Result.MaxDepth = MaxDepth;
+
+  File.setFilePointer(0);
+  IndexBuilder Builder{File, Result.Entries, MaxDepth, std::numeric_limits<std::uint64_t>::max()};
+  int UpperLevel = 0;
+  std::unique_ptr<EbmlElement> Extra(Builder.Scan(Context, NoParent, 0, true, Result.Identity.Size, UpperLevel));
+  Result.Truncated = Builder.Stopped;
+  return Result;
+}
+
+EbmlIndex EbmlIndex::BuildParallel(const FileOpener & OpenFile, const EbmlSemanticContext & Context, unsigned int MaxDepth,
+                                   unsigned int Ranges, std::uint64_t Start, std::uint64_t End)
+{
+  EbmlIndex Result;
+  Result.MaxDepth = MaxDepth;
+  {
+    const auto File = OpenFile();
+    Result.Identity = Identify(*File);
+  }
+  if (End == 0 || End > Result.Identity.Size)
+    End = Result.Identity.Size;
+  if (Start >= End)
+    return Result;
+  Ranges = static_cast<unsigned int>(std::max<std::uint64_t>(1, std::min<std::uint64_t>(Ranges, End - Start)));
+
+  // find the first element of each range
+  std::vector<RangeScan> Scans(Ranges);
+  std::vector<std::future<void>> Workers;
+  Scans[0].Start = Start;
+  for (unsigned int i = 1; i < Ranges; i++) {
+    Workers.emplace_back(std::async(std::launch::async, [&, i] {
+      const auto File = OpenFile();
+      const auto From = Start + (End - Start) * i / Ranges;
+      const auto RangeEnd = Start + (End - Start) * (i + 1) / Ranges;
+      Scans[i].Start = Resync(*File, Context, From, RangeEnd, End);
+    }));
+  }
+  for (auto & Worker : Workers)
+    Worker.get();
+  Workers.clear();
+
+  // scan each range up to the first element of the next one
+  auto RangeStop = [&](unsigned int i) { return i + 1 < Ranges ? Scans[i + 1].Start : End; };
+  for (unsigned int i = 0; i < Ranges; i++) {
+    Workers.emplace_back(std::async(std::launch::async, [&, i] {
+      const auto File = OpenFile();
+      ScanRange(*File, Context, MaxDepth, RangeStop(i), End, Scans[i]);
+    }));
+  }
+  for (auto & Worker : Workers)
+    Worker.get();
+
+  // merge the ranges, a range that doesn't start where the previous one
+  // ended is scanned again from there
+  std::unique_ptr<IOCallback> MergeFile;
+  auto Expected = Start;
+  for (unsigned int i = 0; i < Ranges; i++) {
+    auto & Range = Scans[i];
+    if (Range.Start != Expected) {
+      if (Expected >= RangeStop(i))
+        continue; // the previous range went past this one
+      if (MergeFile == nullptr)
+        MergeFile = OpenFile();
+      Range = RangeScan{};
+      Range.Start = Expected;
+      ScanRange(*MergeFile, Context, MaxDepth, RangeStop(i), End, Range);
+    }
+    const auto Base = static_cast<std::uint32_t>(Result.Entries.size());
+    for (auto & Entry : Range.Entries) {
+      if (Entry.Parent != NoParent)
+        Entry.Parent += Base;
+      Result.Entries.push_back(Entry);
+    }
+    Expected = Range.End;
+    if (Range.Stopped) {
+      Result.Truncated = Range.Truncated;
+      break;
+    }
+  }
+
+  return Result;
+}
+
+void EbmlIndex::Write(IOCallback & Sidecar) const
+{
+  std::array<binary, HeaderSize> Header{};
+  std::copy(IndexMagic.begin(), IndexMagic.end(), Header.begin());
+  Header[7] = static_cast<binary>(FormatVersion);
+  endian::to_big64(static_cast<std::int64_t>(Entries.size()), &Header[8]);
+  endian::to_big64(static_cast<std::int64_t>(Identity.Size), &Header[16]);
+  endian::to_big32(static_cast<std::int32_t>(Identity.StartCrc), &Header[24]);
+  endian::to_big32(static_cast<std::int32_t>(MaxDepth), &Header[28]);
+  Header[32] = Truncated ? IndexFlagTruncated : 0;
+  Sidecar.writeFully(Header.data(), Header.size());
+
+  std::array<binary, EntrySize> Record;
+  for (const auto & Entry : Entries) {
+    Record.fill(0);
+    endian::to_big64(static_cast<std::int64_t>(Entry.Position), &Record[0]);
+    endian::to_big64(static_cast<std::int64_t>(Entry.DataSize), &Record[8]);
+    endian::to_big32(static_cast<std::int32_t>(Entry.Id), &Record[16]);
+    endian::to_big32(static_cast<std::int32_t>(Entry.Parent), &Record[20]);
+    Record[24] = Entry.Depth;
+    Record[25] = Entry.HeadSize;
+    Record[26] = Entry.SizeIsFinite ? EntryFlagSizeIsFinite : 0;
+    Sidecar.writeFully(Record.data(), Record.size());
+  }
+}
+
+void EbmlIndex::DecodeEntry(const binary * Buffer, EbmlIndexEntry & Entry)
+{
+  Entry.Position = static_cast<std::uint64_t>(endian::from_big64(&Buffer[0]));
+  Entry.DataSize = static_cast<std::uint64_t>(endian::from_big64(&Buffer[8]));
+  Entry.Id = static_cast<std::uint32_t>(endian::from_big32(&Buffer[16]));
+  Entry.Parent = static_cast<std::uint32_t>(endian::from_big32(&Buffer[20]));
+  Entry.Depth = Buffer[24];
+  Entry.HeadSize = Buffer[25];
+  Entry.SizeIsFinite = (Buffer[26] & EntryFlagSizeIsFinite) != 0;
+}
+
+static bool CheckSignature(const binary * Header)
+{
+  return std::equal(IndexMagic.begin(), IndexMagic.end(), Header) && Header[7] == EbmlIndex::FormatVersion;
+}
+
+static bool CheckHeader(const binary * Sidecar, std::size_t SidecarSize, std::uint64_t & Count)
+{
+  if (SidecarSize < EbmlIndex::HeaderSize || !CheckSignature(Sidecar))
+    return false;
+  Count = static_cast<std::uint64_t>(endian::from_big64(&Sidecar[8]));
+  return Count <= (SidecarSize - EbmlIndex::HeaderSize) / EbmlIndex::EntrySize;
+}
+
+bool EbmlIndex::EntryAt(const binary * Sidecar, std::size_t SidecarSize, std::size_t Index, EbmlIndexEntry & Entry)
+{
+  std::uint64_t Count;
+  if (!CheckHeader(Sidecar, SidecarSize, Count) || Index >= Count)
+    return false;
+  DecodeEntry(Sidecar + HeaderSize + Index * EntrySize, Entry);
+  return true;
+}
+
+bool EbmlIndex::Load(const binary * Sidecar, std::size_t SidecarSize, IOCallback & File)
+{
+  std::uint64_t Count;
+  if (!CheckHeader(Sidecar, SidecarSize, Count))
+    return false;
+
+  EbmlIndex Result;
+  Result.Identity.Size = static_cast<std::uint64_t>(endian::from_big64(&Sidecar[16]));
+  Result.Identity.StartCrc = static_cast<std::uint32_t>(endian::from_big32(&Sidecar[24]));
+  Result.MaxDepth = static_cast<std::uint32_t>(endian::from_big32(&Sidecar[28]));
+  Result.Truncated = (Sidecar[32] & IndexFlagTruncated) != 0;
+  if (!Result.Matches(File))
+    return false;
+
+  Result.Entries.resize(Count);
+  for (std::size_t i = 0; i < Count; i++)
+    DecodeEntry(Sidecar + HeaderSize + i * EntrySize, Result.Entries[i]);
+
+  *this = std::move(Result);
+  return true;
+}
+
+bool EbmlIndex::Read(IOCallback & Sidecar, IOCallback & File)
+{
+  std::array<binary, HeaderSize> Header;
+  if (Sidecar.read(Header.data(), Header.size()) != Header.size())
+    return false;
+  if (!CheckSignature(Header.data()))
+    return false;
+  const auto Count = static_cast<std::uint64_t>(endian::from_big64(&Header[8]));
+  if (Count > (std::numeric_limits<std::size_t>::max() - HeaderSize) / EntrySize)
+    return false;
+
+  // the buffer grows with the entries actually read
+  std::vector<binary> Buffer(Header.begin(), Header.end());
+  for (std::uint64_t Loaded = 0; Loaded < Count; ) {
+    const auto Chunk = static_cast<std::size_t>(std::min<std::uint64_t>(Count - Loaded, ReadChunkEntries)) * EntrySize;
+    const auto Offset = Buffer.size();
+    Buffer.resize(Offset + Chunk);
+    if (Sidecar.read(&Buffer[Offset], Chunk) != Chunk)
+      return false;
+    Loaded += Chunk / EntrySize;
+  }
+  return Load(Buffer.data(), Buffer.size(), File);
+}
+
+bool EbmlIndex::Matches(IOCallback & File) const
+{
+  const auto Current = Identify(File);
+  return Current.Size == Identity.Size && Current.StartCrc == Identity.StartCrc;
+}
+
+std::size_t EbmlIndex::Find(const EbmlId & Id, std::size_t From) const
+{
+  for (std::size_t i = From; i < Entries.size(); i++) {
+    if (Entries[i].Id == Id.GetValue())
+      return i;
+  }
+  return Entries.size();
+}
+
+EbmlElement * EbmlIndex::OpenElement(IOCallback & File, std::size_t Index, const EbmlSemanticContext & Context) const
+{
+  const auto & Entry = Entries.at(Index);
+  File.setFilePointer(Entry.Position);
+  int UpperLevel = 0;
+  auto * Result = EbmlElement::FindNextElement(File, Context, UpperLevel, std::numeric_limits<std::uint64_t>::max(), true);
+  if (Result == nullptr)
+    return nullptr;
+  if (Result->GetElementPosition() != Entry.Position || EbmlId(*Result).GetValue() != Entry.Id) {
+    delete Result;
+    return nullptr;
+  }
+  return Result;
+}
+
+} // namespace libebml
@@ -7,39 +7,184 @@
 */
 
 #include "ebml/EbmlMaster.h"
+#include "ebml/EbmlBinary.h"
+#include "ebml/EbmlRawElement.h"
+#include "ebml/EbmlStats.h"
 #include "ebml/EbmlStream.h"
 #include "ebml/MemIOCallback.h"
+#include "ebml/MemReadIOCallback.h"
+#include "ebml/MemWriteIOCallback.h"
 
 #include <cassert>
 #include <algorithm>
+#include <bitset>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace libebml {
 
+/// set while the parser creates elements that are going to be read
+static thread_local bool bCreatingForReading = false;
+
+/// protects the shared children of the masters copied concurrently
+static std::mutex ShareMutex;
+
+EbmlMaster::CreateForReading::CreateForReading()
+  :bPrevious(bCreatingForReading)
+{
+  bCreatingForReading = true;
+}
+
+EbmlMaster::CreateForReading::~CreateForReading()
+{
+  bCreatingForReading = bPrevious;
+}
+
 EbmlMaster::EbmlMaster(const EbmlCallbacksMaster & classInfo, bool bSizeIsknown)
  :EbmlElement(classInfo, 0)
 {
   SetSizeInfinite(!bSizeIsknown);
   SetValueIsSet();
-  ProcessMandatory();
+  EnableChecksum(bChecksumUsedByDefault);
+  // the mandatory elements would be deleted by Read()
+  if (!bCreatingForReading)
+    ProcessMandatory();
 }
 
 EbmlMaster::EbmlMaster(const EbmlMaster & ElementToClone)
  :EbmlElement(ElementToClone)
- ,bChecksumUsed(ElementToClone.bChecksumUsed)
- ,Checksum(ElementToClone.Checksum)
+ ,Checksum(ElementToClone.Checksum ? std::make_unique<EbmlCrc32>(*ElementToClone.Checksum) : nullptr)
+ ,bCopyOnWrite(ElementToClone.bCopyOnWrite)
 {
   SetSizeInfinite(!IsFiniteSize());
+  if (bCopyOnWrite) {
+    // share the children, they will be copied when modified
+    const std::lock_guard<std::mutex> Lock(ShareMutex);
+    ElementToClone.ShareAll();
+    ElementList = ElementToClone.ElementList;
+    SharedElements = ElementToClone.SharedElements;
+    return;
+  }
   ElementList.reserve(ElementToClone.ListSize());
   // add a clone of the list
   for (const auto& e : ElementToClone.ElementList)
     ElementList.push_back(e->Clone());
 }
 
+EbmlMaster::EbmlMaster(EbmlMaster && ElementToMove) noexcept
+ :EbmlElement(std::move(ElementToMove))
+ ,ElementList(std::move(ElementToMove.ElementList))
+ ,Checksum(std::move(ElementToMove.Checksum))
+ ,bCopyOnWrite(ElementToMove.bCopyOnWrite)
+ ,SharedElements(std::move(ElementToMove.SharedElements))
+{
+  ElementToMove.ElementList.clear();
+  ElementToMove.SharedElements.clear();
+}
+
+EbmlMaster & EbmlMaster::operator=(EbmlMaster && ElementToMove) noexcept
+{
+  if (this == &ElementToMove)
+    return *this;
+
+  DeleteElements();
+  EbmlElement::operator=(std::move(ElementToMove));
+  ElementList = std::move(ElementToMove.ElementList);
+  ElementToMove.ElementList.clear();
+  SharedElements = std::move(ElementToMove.SharedElements);
+  ElementToMove.SharedElements.clear();
+  Checksum = std::move(ElementToMove.Checksum);
+  bCopyOnWrite = ElementToMove.bCopyOnWrite;
+  return *this;
+}
+
 EbmlMaster::~EbmlMaster()
 {
+  DeleteElements();
+}
+
+void EbmlMaster::DeleteElements()
+{
+  for (auto Element : ElementList) {
+    if (!IsShared(Element))
+      delete Element;
+  }
+  ElementList.clear();
+  SharedElements.clear();
+}
+
+static bool SharedAddressLess(const std::shared_ptr<EbmlElement> & Shared, const EbmlElement * Element)
+{
+  return std::less<const EbmlElement *>()(Shared.get(), Element);
+}
+
+bool EbmlMaster::IsShared(const EbmlElement * Element) const
+{
+  if (SharedElements.empty())
+    return false;
+  auto Itr = std::lower_bound(SharedElements.begin(), SharedElements.end(), Element, SharedAddressLess);
+  return Itr != SharedElements.end() && Itr->get() == Element;
+}
+
+void EbmlMaster::ShareAll() const
+{
+  if (SharedElements.size() == ElementList.size())
+    return; // all shared already
+
+  for (auto Element : ElementList) {
+    if (!IsShared(Element)) {
+      auto Itr = std::lower_bound(SharedElements.begin(), SharedElements.end(), Element, SharedAddressLess);
+      SharedElements.emplace(Itr, Element);
+    }
+  }
+}
+
+bool EbmlMaster::ReleaseShared(const EbmlElement * Element)
+{
+  if (SharedElements.empty())
+    return false;
+
+  auto Itr = std::lower_bound(SharedElements.begin(), SharedElements.end(), Element, SharedAddressLess);
+  if (Itr == SharedElements.end() || Itr->get() != Element)
+    return false;
+
+  SharedElements.erase(Itr);
+  return true;
+}
+
+EbmlElement * EbmlMaster::Unshare(std::size_t Index)
+{
+  auto Element = ElementList[Index];
+  if (!IsShared(Element))
+    return Element;
+
+  // a copy of a copy-on-write master shares its own children
+  ElementList[Index] = Element->Clone();
+  ReleaseShared(Element);
+  return ElementList[Index];
+}
+
+void EbmlMaster::UnshareElements()
+{
+  for (std::size_t Index = 0; Index < ElementList.size(); Index++) {
+    if (IsShared(ElementList[Index]))
+      ElementList[Index] = ElementList[Index]->Clone();
+  }
+  SharedElements.clear();
+}
+
+void EbmlMaster::EnableCopyOnWrite(bool bIsEnabled)
+{
+  bCopyOnWrite = bIsEnabled;
   for (auto Element : ElementList) {
-    delete Element;
+    if (Element->IsMaster())
+      static_cast<EbmlMaster *>(Element)->EnableCopyOnWrite(bIsEnabled);
   }
 }
 
@@ -55,6 +200,36 @@ const EbmlSemantic & EbmlSemanticContextMaster::GetSemantic(std::size_t i) const
 }
 
 
+namespace {
+
+/// memory of the size of the rendered elements, giving the positions of the place it's written to in the output
+class RenderBuffer {
+  public:
+    RenderBuffer(std::uint64_t Base, std::uint64_t Size)
+      :Memory(static_cast<std::size_t>(Size))
+      ,Output(Memory.data(), Memory.size(), Base)
+    {}
+
+    IOCallback & GetOutput() { return Output; }
+
+    bool IsOverflow() const { return Output.IsOverflow(); }
+    std::uint64_t GetRequiredSize() const { return Output.GetRequiredSize(); }
+
+    /// the data rendered, which must fit in the buffer
+    const binary *GetData() const {
+      if (Output.IsOverflow())
+        throw std::runtime_error("elements rendered larger than their size");
+      return Output.GetDataBuffer();
+    }
+    std::size_t GetDataSize() const { return Output.GetDataBufferSize(); }
+
+  private:
+    std::vector<binary> Memory;
+    MemWriteIOCallback Output;
+};
+
+} // namespace
+
 /*!
   \todo handle exception on errors
   \todo write all the Mandatory elements in the Context, otherwise assert
@@ -67,35 +242,136 @@ filepos_t EbmlMaster::RenderData(IOCallback & output, bool bForceRender, const S
     assert(CheckMandatory());
   }
 
-  if (!bChecksumUsed) { // old school
+  if (!Checksum) { // old school
     for (auto Element : ElementList) {
       if (!Element->CanWrite(writeFilter))
         continue;
       Result += Element->Render(output, writeFilter, false ,bForceRender);
     }
   } else { // new school
-    MemIOCallback TmpBuf(GetSize() - 6);
-    for (auto Element : ElementList) {
-      if (!Element->CanWrite(writeFilter))
-        continue;
-      Element->Render(TmpBuf, writeFilter, false ,bForceRender);
-    }
-    std::uint64_t memSize = TmpBuf.GetDataBufferSize();
-    const binary *memStart = TmpBuf.GetDataBuffer();
+    // the children are written after the CRC-32
+    const auto RenderChildren = [&](std::uint64_t Size) {
+      auto Buffer = std::make_unique<RenderBuffer>(output.getFilePointer() + Checksum->ElementSize(), Size);
+      for (auto Element : ElementList) {
+        if (!Element->CanWrite(writeFilter))
+          continue;
+        Element->Render(Buffer->GetOutput(), writeFilter, false ,bForceRender);
+      }
+      return Buffer;
+    };
+    auto Rendered = RenderChildren(GetSize() - 6);
+    if (Rendered->IsOverflow()) // the children changed size since UpdateSize()
+      Rendered = RenderChildren(Rendered->GetRequiredSize());
+    const RenderBuffer & TmpBuf = *Rendered;
+    std::uint64_t memSize = TmpBuf.GetDataSize();
+    const binary *memStart = TmpBuf.GetData();
     while (memSize != 0) {
       const auto fillSize = static_cast<std::uint32_t>(std::min<std::uint64_t>(std::numeric_limits<std::uint32_t>::max(), memSize));
-      Checksum.FillCRC32(memStart, fillSize);
+      Checksum->FillCRC32(memStart, fillSize);
       memStart += fillSize;
       memSize -= fillSize;
     }
-    Result += Checksum.Render(output, writeFilter, false ,bForceRender);
-    output.writeFully(TmpBuf.GetDataBuffer(), TmpBuf.GetDataBufferSize());
-    Result += TmpBuf.GetDataBufferSize();
+    Result += Checksum->Render(output, writeFilter, false ,bForceRender);
+    output.writeFully(TmpBuf.GetData(), TmpBuf.GetDataSize());
+    Result += TmpBuf.GetDataSize();
   }
 
   return Result;
 }
 
+filepos_t EbmlMaster::RenderParallel(IOCallback & output, unsigned Threads, const ShouldWrite & writeFilter, bool bKeepPosition, bool bForceRender)
+{
+  if (!CanWrite(writeFilter))
+    return 0;
+  if (Threads <= 1 || !IsFiniteSize() || HasSharedState())
+    return Render(output, writeFilter, bKeepPosition, bForceRender);
+
+  if (!bForceRender) {
+    assert(CheckMandatory());
+  }
+
+  EBML_STATS_TRACE(Render, *this);
+  // the sizes of all the children are updated with the head
+  filepos_t Result = RenderHead(output, bForceRender, writeFilter, bKeepPosition);
+
+  std::uint64_t Position = output.getFilePointer();
+  if (Checksum)
+    Position += Checksum->ElementSize();
+  std::vector<EbmlElement *> Children;
+  std::vector<std::uint64_t> Positions;
+  for (auto Element : ElementList) {
+    if (!Element->CanWrite(writeFilter))
+      continue;
+    Children.push_back(Element);
+    Positions.push_back(Position);
+    Position += Element->ElementSize(writeFilter);
+  }
+
+  const auto RenderChild = [&](std::size_t Index) {
+    auto Buffer = std::make_unique<RenderBuffer>(Positions[Index], Children[Index]->ElementSize(writeFilter));
+    Children[Index]->Render(Buffer->GetOutput(), writeFilter, false, bForceRender);
+    return Buffer;
+  };
+
+  // the CRC-32 is written before the children, they are all kept in memory
+  std::vector<std::unique_ptr<RenderBuffer>> Rendered;
+  std::deque<std::future<std::unique_ptr<RenderBuffer>>> Pending;
+  if (Checksum)
+    Checksum->ResetCRC();
+  std::size_t Next = 0;
+  while (Next < Children.size() && Pending.size() < Threads)
+    Pending.push_back(std::async(std::launch::async, RenderChild, Next++));
+  while (!Pending.empty()) {
+    auto Buffer = Pending.front().get();
+    Pending.pop_front();
+    if (Next < Children.size())
+      Pending.push_back(std::async(std::launch::async, RenderChild, Next++));
+
+    if (Checksum) {
+      std::uint64_t memSize = Buffer->GetDataSize();
+      const binary *memStart = Buffer->GetData();
+      while (memSize != 0) {
+        const auto fillSize = static_cast<std::uint32_t>(std::min<std::uint64_t>(std::numeric_limits<std::uint32_t>::max(), memSize));
+        Checksum->Update(memStart, fillSize);
+        memStart += fillSize;
+        memSize -= fillSize;
+      }
+      Rendered.push_back(std::move(Buffer));
+    } else {
+      output.writeFully(Buffer->GetData(), Buffer->GetDataSize());
+      Result += Buffer->GetDataSize();
+    }
+  }
+
+  if (Checksum) {
+    Checksum->Finalize();
+    Result += Checksum->Render(output, writeFilter, false, bForceRender);
+    for (const auto & Buffer : Rendered) {
+      output.writeFully(Buffer->GetData(), Buffer->GetDataSize());
+      Result += Buffer->GetDataSize();
+    }
+  }
+
+  return Result;
+}
+
+bool EbmlMaster::HasSharedState() const
+{
+  if (!SharedElements.empty())
+    return true;
+  for (const auto * Element : ElementList) {
+    if (Element->IsMaster()) {
+      if (static_cast<const EbmlMaster *>(Element)->HasSharedState())
+        return true;
+    } else if (const auto * Binary = dynamic_cast<const EbmlBinary *>(Element)) {
+      if (Binary->IsDeferred())
+        return true;
+    } else if (dynamic_cast<const EbmlRawElement *>(Element) != nullptr)
+      return true;
+  }
+  return false;
+}
+
 /*!
   \todo We might be able to forbid elements that don't exist in the context
 */
@@ -109,6 +385,14 @@ bool EbmlMaster::PushElement(EbmlElement & element)
   return false;
 }
 
+bool EbmlMaster::PushElement(std::unique_ptr<EbmlElement> element)
+{
+  if (!element || !PushElement(*element))
+    return false;
+  element.release();
+  return true;
+}
+
 filepos_t EbmlMaster::UpdateSize(const ShouldWrite & writeFilter, bool bForceRender)
 {
   if (!CanWrite(writeFilter))
@@ -134,8 +418,8 @@ filepos_t EbmlMaster::UpdateSize(const ShouldWrite & writeFilter, bool bForceRen
 #endif // !NDEBUG
     SetSize_(GetSize() + SizeToAdd);
   }
-  if (bChecksumUsed) {
-    SetSize_(GetSize() + Checksum.ElementSize());
+  if (Checksum) {
+    SetSize_(GetSize() + Checksum->ElementSize());
   }
 
   return GetSize();
@@ -190,27 +474,97 @@ bool EbmlMaster::ProcessMandatory()
   return true;
 }
 
-bool EbmlMaster::CheckMandatory() const
+namespace {
+
+/// one bit per element of a semantic context, allocated only for large contexts
+class SemanticBits {
+  public:
+    explicit SemanticBits(std::size_t Size) {
+      if (Size > Small.size())
+        Large.resize(Size);
+    }
+
+    /// set the bit and return its previous value
+    bool Set(std::size_t Index) {
+      if (Large.empty()) {
+        const bool Previous = Small.test(Index);
+        Small.set(Index);
+        return Previous;
+      }
+      const bool Previous = Large[Index];
+      Large[Index] = true;
+      return Previous;
+    }
+
+    bool Test(std::size_t Index) const {
+      return Large.empty() ? Small.test(Index) : Large[Index];
+    }
+
+  private:
+    std::bitset<64> Small;
+    std::vector<bool> Large;
+};
+
+} // namespace
+
+/*!
+  \brief mark the context elements found in the children in a single pass
+  \param Report where to store the errors, stop at the first missing mandatory element if nullptr
+*/
+bool EbmlMaster::ScanSemantic(SemanticReport * Report) const
 {
   const auto & MasterContext = ContextMaster();
+  const std::size_t ContextSize = EBML_CTX_SIZE(MasterContext);
+  SemanticBits Found(ContextSize);
+  SemanticBits Reported(ContextSize);
+  bool Result = true;
+  if (Report != nullptr) {
+    Report->Missing.clear();
+    Report->Duplicated.clear();
+  }
 
-  for (unsigned int EltIdx = 0; EltIdx < EBML_CTX_SIZE(MasterContext); EltIdx++) {
-    if (EBML_CTX_IDX(MasterContext,EltIdx).IsMandatory()) {
-      const auto & semcb = EBML_CTX_IDX_INFO(MasterContext,EltIdx);
-      if (FindFirstElt(semcb) == nullptr) {
-        const bool hasDefaultValue = semcb.HasDefault();
-
-#if !defined(NDEBUG)
-        // you are missing this Mandatory element
-//         const char * MissingName = semcb.GetName();
-#endif // !NDEBUG
-        if (!hasDefaultValue)
-          return false;
+  // children are usually in the order of the context, resume from the last match
+  std::size_t EltIdx = 0;
+  for (const auto Element : ElementList) {
+    const auto & Id = Element->GetClassId();
+    for (std::size_t Tries = 0; Tries < ContextSize; Tries++) {
+      if (EBML_CTX_IDX_ID(MasterContext,EltIdx) == Id) {
+        if (Found.Set(EltIdx) && Report != nullptr && EBML_CTX_IDX(MasterContext,EltIdx).IsUnique() && !Reported.Set(EltIdx)) {
+          Report->Duplicated.push_back(&EBML_CTX_IDX_INFO(MasterContext,EltIdx));
+          Result = false;
+        }
+        break;
       }
+      if (++EltIdx == ContextSize)
+        EltIdx = 0;
     }
+    // global elements are not in the context
   }
 
-  return true;
+  for (EltIdx = 0; EltIdx < ContextSize; EltIdx++) {
+    if (Found.Test(EltIdx) || !EBML_CTX_IDX(MasterContext,EltIdx).IsMandatory())
+      continue;
+    const auto & semcb = EBML_CTX_IDX_INFO(MasterContext,EltIdx);
+    if (semcb.HasDefault())
+      continue;
+    // you are missing this Mandatory element
+    if (Report == nullptr)
+      return false;
+    Report->Missing.push_back(&semcb);
+    Result = false;
+  }
+
+  return Result;
+}
+
+bool EbmlMaster::CheckMandatory() const
+{
+  return ScanSemantic(nullptr);
+}
+
+bool EbmlMaster::CheckSemantic(SemanticReport & Report) const
+{
+  return ScanSemantic(&Report);
 }
 
 EbmlElement *EbmlMaster::FindFirstElt(const EbmlCallbacks & Callbacks) const
@@ -223,9 +577,10 @@ EbmlElement *EbmlMaster::FindFirstElt(const EbmlCallbacks & Callbacks) const
 
 EbmlElement *EbmlMaster::FindFirstElt(const EbmlCallbacks & Callbacks, bool bCreateIfNull)
 {
-  auto e = FindFirstElt(Callbacks);
-  if (e)
-    return e;
+  auto it = std::find_if(ElementList.begin(), ElementList.end(), [&](const EbmlElement *Element)
+    { return EbmlId(*Element) == EBML_INFO_ID(Callbacks); });
+  if (it != ElementList.end())
+    return Unshare(it - ElementList.begin());
 
   if (bCreateIfNull) {
     // add the element
@@ -241,9 +596,15 @@ EbmlElement *EbmlMaster::FindFirstElt(const EbmlCallbacks & Callbacks, bool bCre
 */
 EbmlElement *EbmlMaster::FindNextElt(const EbmlElement & PastElt, bool bCreateIfNull)
 {
-  EbmlElement *e = FindNextElt(PastElt);
-  if (e)
-    return e;
+  auto it = std::find(ElementList.begin(), ElementList.end(), &PastElt);
+  if (it != ElementList.end()) {
+    it = std::find_if(it + 1, ElementList.end(), [&](auto &&element) {
+      return EbmlId(PastElt) == EbmlId(*element);
+    });
+
+    if (it != ElementList.end())
+      return Unshare(it - ElementList.begin());
+  }
 
   if (bCreateIfNull) {
     // add the element
@@ -282,6 +643,16 @@ EbmlElement *EbmlMaster::AddNewElt(const EbmlCallbacks & Callbacks)
   return NewElt;
 }
 
+void EbmlMaster::AddMemoryUsage(EbmlMemoryReport & Report) const
+{
+  Report.Add(*this, ObjectSize(), 0,
+             ElementList.capacity() * sizeof(EbmlElement *) + SharedElements.capacity() * sizeof(std::shared_ptr<EbmlElement>));
+  if (Checksum)
+    Checksum->AddMemoryUsage(Report);
+  for (const auto * Element : ElementList)
+    Element->AddMemoryUsage(Report);
+}
+
 void EbmlMaster::Sort()
 {
   std::sort(ElementList.begin(), ElementList.end(), EbmlElement::CompareElements);
@@ -297,12 +668,16 @@ void EbmlMaster::Read(EbmlStream & inDataStream, const EbmlSemanticContext & sCo
   if (ReadFully == SCOPE_NO_DATA)
     return;
 
+  if (ReadFully == SCOPE_ALL_DATA && IsFiniteSize() && GetSize() != 0 && GetSize() <= inDataStream.GetReadInMemoryThreshold() &&
+      dynamic_cast<MemReadIOCallback *>(&inDataStream.I_O()) == nullptr) {
+    if (ReadInMemory(inDataStream, sContext, UpperEltFound, FoundElt, AllowDummyElt))
+      return;
+  }
+
+  EBML_STATS_TRACE(Read, *this);
   EbmlElement * ElementLevelA;
   // remove all existing elements, including the mandatory ones...
-  for (auto Element : ElementList) {
-    delete Element;
-  }
-  ElementList.clear();
+  DeleteElements();
   std::uint64_t MaxSizeToRead;
 
   if (IsFiniteSize())
@@ -315,6 +690,7 @@ void EbmlMaster::Read(EbmlStream & inDataStream, const EbmlSemanticContext & sCo
   {
     inDataStream.I_O().setFilePointer(GetSizePosition() + GetSizeLength(), seek_beginning);
     ElementLevelA = inDataStream.FindNextElement(sContext, UpperEltFound, MaxSizeToRead, AllowDummyElt);
+    EBML_STATS_ADD(ElementsCreated, ElementLevelA != nullptr ? 1 : 0);
     while (ElementLevelA != nullptr && UpperEltFound <= 0 && MaxSizeToRead > 0) {
       if (IsFiniteSize() && ElementLevelA->IsFiniteSize())
         MaxSizeToRead = GetEndPosition() - ElementLevelA->GetEndPosition(); // even if it's the default value
@@ -322,8 +698,10 @@ void EbmlMaster::Read(EbmlStream & inDataStream, const EbmlSemanticContext & sCo
         if (ElementLevelA->IsFiniteSize()) {
           ElementLevelA->SkipData(inDataStream, sContext);
           delete ElementLevelA; // forget this unknown element
+          EBML_STATS_ADD(ElementsDeleted, 1);
         } else {
           delete ElementLevelA; // forget this unknown element
+          EBML_STATS_ADD(ElementsDeleted, 1);
           break;
         }
       } else {
@@ -339,11 +717,11 @@ void EbmlMaster::Read(EbmlStream & inDataStream, const EbmlSemanticContext & sCo
         }
 
         // Discard elements that couldn't be read properly if
-        // SCOPE_ALL_DATA has been requested. This can happen
-        // e.g. if block data is defective.
+        // SCOPE_ALL_DATA or SCOPE_DEFERRED_DATA has been requested.
+        // This can happen e.g. if block data is defective.
         bool DeleteElement = true;
 
-        if (ElementLevelA->ValueIsSet() || (ReadFully != SCOPE_ALL_DATA)) {
+        if (ElementLevelA->ValueIsSet() || (ReadFully != SCOPE_ALL_DATA && ReadFully != SCOPE_DEFERRED_DATA)) {
           ElementList.push_back(ElementLevelA);
           DeleteElement = false;
         }
@@ -351,11 +729,15 @@ void EbmlMaster::Read(EbmlStream & inDataStream, const EbmlSemanticContext & sCo
         // just in case
         if (ElementLevelA->IsFiniteSize()) {
           ElementLevelA->SkipData(inDataStream, EBML_CONTEXT(ElementLevelA));
-          if (DeleteElement)
+          if (DeleteElement) {
             delete ElementLevelA;
+            EBML_STATS_ADD(ElementsDeleted, 1);
+          }
         } else {
-          if (DeleteElement)
+          if (DeleteElement) {
             delete ElementLevelA;
+            EBML_STATS_ADD(ElementsDeleted, 1);
+          }
 
           if (UpperEltFound) {
             --UpperEltFound;
@@ -363,6 +745,7 @@ void EbmlMaster::Read(EbmlStream & inDataStream, const EbmlSemanticContext & sCo
               goto processCrc;
             if (MaxSizeToRead <= 0) {
               delete FoundElt;
+              EBML_STATS_ADD(ElementsDeleted, 1);
               FoundElt = nullptr;
               goto processCrc;
             }
@@ -379,6 +762,7 @@ void EbmlMaster::Read(EbmlStream & inDataStream, const EbmlSemanticContext & sCo
           goto processCrc;
         if (MaxSizeToRead <= 0) {
           delete FoundElt;
+          EBML_STATS_ADD(ElementsDeleted, 1);
           FoundElt = nullptr;
           goto processCrc;
         }
@@ -402,6 +786,7 @@ void EbmlMaster::Read(EbmlStream & inDataStream, const EbmlSemanticContext & sCo
         goto processCrc;// this level is finished
 
       ElementLevelA = inDataStream.FindNextElement(sContext, UpperEltFound, MaxSizeToRead, AllowDummyElt);
+      EBML_STATS_ADD(ElementsCreated, ElementLevelA != nullptr ? 1 : 0);
     }
     if (UpperEltFound > 0) {
       FoundElt = ElementLevelA;
@@ -414,40 +799,88 @@ processCrc:
         return EbmlId(*element) == EBML_ID(EbmlCrc32);
       });
   if (CrcItr != ElementList.end()) {
-    bChecksumUsed = true;
-    // remove the element
-    Checksum = *(static_cast<EbmlCrc32 *>(*CrcItr));
-  }
-
-  if (bChecksumUsed)
-  {
-    delete *CrcItr;
+    // take the element out of the list
+    Checksum.reset(static_cast<EbmlCrc32 *>(*CrcItr));
     Remove(CrcItr);
   }
 
   SetValueIsSet();
 }
 
+bool EbmlMaster::ReadInMemory(EbmlStream & inDataStream, const EbmlSemanticContext & sContext, int & UpperEltFound, EbmlElement * & FoundElt, bool AllowDummyElt)
+{
+  if (GetSize() > std::numeric_limits<std::size_t>::max())
+    return false;
+
+  auto & input = inDataStream.I_O();
+  const std::uint64_t DataStart = GetSizePosition() + GetSizeLength();
+  std::vector<binary> Payload(static_cast<std::size_t>(GetSize()));
+  input.setFilePointer(DataStart, seek_beginning);
+  if (input.read(Payload.data(), Payload.size()) != Payload.size())
+    return false; // the regular reading handles truncated masters
+
+  // the memory stream gives the same positions as the file
+  MemReadIOCallback Memory(Payload.data(), Payload.size(), DataStart);
+  EbmlStream MemoryStream(Memory);
+  EbmlMaster::Read(MemoryStream, sContext, UpperEltFound, FoundElt, AllowDummyElt, SCOPE_ALL_DATA);
+  input.setFilePointer(Memory.getFilePointer(), seek_beginning);
+  return true;
+}
+
 void EbmlMaster::Remove(std::size_t Index)
 {
   if (Index < ElementList.size()) {
+    ReleaseShared(ElementList[Index]);
     ElementList.erase(ElementList.begin() + Index);
   }
 }
 
 void EbmlMaster::Remove(EBML_MASTER_ITERATOR & Itr)
 {
+  ReleaseShared(*Itr);
   ElementList.erase(Itr);
 }
 
 void EbmlMaster::Remove(EBML_MASTER_RITERATOR & Itr)
 {
-  ElementList.erase(Itr.base());
+  auto Base = Itr.base();
+  ReleaseShared(*Base);
+  ElementList.erase(Base);
+}
+
+std::unique_ptr<EbmlElement> EbmlMaster::Detach(std::size_t Index)
+{
+  if (Index >= ElementList.size())
+    return nullptr;
+
+  std::unique_ptr<EbmlElement> Result(Unshare(Index));
+  ElementList.erase(ElementList.begin() + Index);
+  return Result;
+}
+
+std::unique_ptr<EbmlElement> EbmlMaster::Detach(const EbmlElement & Element)
+{
+  auto Itr = std::find(ElementList.begin(), ElementList.end(), &Element);
+  if (Itr == ElementList.end())
+    return nullptr;
+
+  return Detach(Itr - ElementList.begin());
+}
+
+std::vector<std::unique_ptr<EbmlElement>> EbmlMaster::DetachAll()
+{
+  std::vector<std::unique_ptr<EbmlElement>> Result;
+  UnshareAll();
+  Result.reserve(ElementList.size());
+  for (auto Element : ElementList)
+    Result.emplace_back(Element);
+  ElementList.clear();
+  return Result;
 }
 
 bool EbmlMaster::VerifyChecksum() const
 {
-  if (!bChecksumUsed)
+  if (!Checksum)
     return true;
 
   EbmlCrc32 aChecksum;
@@ -466,7 +899,7 @@ bool EbmlMaster::VerifyChecksum() const
     memSize -= fillSize;
   }
 
-  return (aChecksum.GetCrc32() == Checksum.GetCrc32());
+  return (aChecksum.GetCrc32() == Checksum->GetCrc32());
 }
 
 bool EbmlMaster::InsertElement(EbmlElement & element, std::size_t position)
@@ -488,5 +921,74 @@ bool EbmlMaster::InsertElement(EbmlElement & element, const EbmlElement & before
   return true;
 }
 
+bool EbmlMaster::InsertElements(std::vector<std::unique_ptr<EbmlElement>> elements, std::size_t position)
+{
+  if (position > ElementList.size())
+    return false;
+
+  // the elements are released once the list can hold them
+  ElementList.insert(ElementList.begin() + position, elements.size(), nullptr);
+  for (auto & Element : elements)
+    ElementList[position++] = Element.release();
+  return true;
+}
+
+void EbmlMaster::PushElements(std::vector<std::unique_ptr<EbmlElement>> elements)
+{
+  InsertElements(std::move(elements), ElementList.size());
+}
+
+std::vector<EbmlMaster::ExtractedChild> EbmlMaster::ExtractIf(const ChildPredicate & Predicate)
+{
+  // the predicate and the allocations may throw, they are done before the list is modified
+  std::vector<EbmlElement *> Kept;
+  std::vector<EbmlElement *> Matching;
+  Kept.reserve(ElementList.size());
+  for (auto Element : ElementList)
+    (Predicate(*Element) ? Matching : Kept).push_back(Element);
+  if (Matching.empty())
+    return {};
+  std::vector<ExtractedChild> Result(Matching.size());
+
+  bool HasShared = false;
+  for (std::size_t i = 0; i < Matching.size(); i++) {
+    auto Shared = std::lower_bound(SharedElements.begin(), SharedElements.end(), Matching[i], SharedAddressLess);
+    if (Shared != SharedElements.end() && Shared->get() == Matching[i]) {
+      Result[i].Shared = *Shared;
+      HasShared = true;
+    } else
+      Result[i].Owned.reset(Matching[i]);
+  }
+  ElementList.swap(Kept);
+
+  if (HasShared) {
+    std::sort(Matching.begin(), Matching.end(), std::less<const EbmlElement *>());
+    SharedElements.erase(std::remove_if(SharedElements.begin(), SharedElements.end(),
+      [&Matching](const std::shared_ptr<EbmlElement> & Shared) {
+        return std::binary_search(Matching.begin(), Matching.end(), Shared.get(), std::less<const EbmlElement *>());
+      }), SharedElements.end());
+  }
+  return Result;
+}
+
+std::size_t EbmlMaster::RemoveIf(const ChildPredicate & Predicate)
+{
+  // the removed children are deleted or released with the result
+  return ExtractIf(Predicate).size();
+}
+
+std::vector<std::unique_ptr<EbmlElement>> EbmlMaster::DetachIf(const ChildPredicate & Predicate)
+{
+  auto Extracted = ExtractIf(Predicate);
+  std::vector<std::unique_ptr<EbmlElement>> Result;
+  Result.reserve(Extracted.size());
+  for (auto & Child : Extracted) {
+    if (Child.Owned)
+      Result.push_back(std::move(Child.Owned));
+    else
+      Result.emplace_back(Child.Shared->Clone());
+  }
+  return Result;
+}
 
 } // namespace libebml
@@ -0,0 +1,55 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \author Steve Lhomme     <robux4 @ users.sf.net>
+*/
+#include "ebml/EbmlRawElement.h"
+#include "ebml/EbmlContexts.h"
+
+#include <stdexcept>
+
+namespace libebml {
+
+static constexpr EbmlDocVersion AllEbmlVersions{"ebml"};
+
+static EbmlElement & CreateRawElement()
+{
+  throw std::logic_error("raw elements are created from an existing element");
+}
+
+static constexpr const EbmlSemanticContext Context_EbmlRawElement = EbmlSemanticContext(nullptr, GetEbmlGlobal_Context, nullptr);
+constexpr const EbmlCallbacks EbmlRawElement::ClassInfos(CreateRawElement, EbmlRawElement::DefaultRawId, false, false, "RawElement", Context_EbmlRawElement, AllEbmlVersions);
+
+EbmlRawElement::EbmlRawElement(IOCallback & aSource, const EbmlElement & Element)
+  :EbmlElement(EbmlRawElement::ClassInfos, 0, true)
+  ,Source(&aSource)
+  ,RawId(EbmlId(Element))
+  ,SourcePosition(Element.GetDataStart())
+{
+  if (!Element.IsFiniteSize())
+    throw std::invalid_argument("raw elements need a known size");
+  SetSize_(Element.GetSize());
+  SetSizeLength(Element.GetSizeLength());
+}
+
+filepos_t EbmlRawElement::RenderData(IOCallback & output, bool /* bForceRender */, const ShouldWrite & /* writeFilter */)
+{
+  return output.CopyFrom(*Source, SourcePosition, GetSize());
+}
+
+filepos_t EbmlRawElement::ReadData(IOCallback & input, ScopeMode /* ReadFully */)
+{
+  Source = &input;
+  SourcePosition = input.getFilePointer();
+  input.setFilePointer(GetSize(), seek_current);
+  return GetSize();
+}
+
+filepos_t EbmlRawElement::UpdateSize(const ShouldWrite & /* writeFilter */, bool /* bForceRender */)
+{
+  return GetSize();
+}
+
+} // namespace libebml
@@ -0,0 +1,64 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \author Steve Lhomme     <robux4 @ users.sf.net>
+*/
+#include "ebml/EbmlStats.h"
+#include "ebml/EbmlElement.h"
+
+namespace libebml {
+
+#if defined(EBML_ENABLE_STATS)
+thread_local EbmlParserStats EbmlStatsState::Counters;
+std::atomic<EbmlTraceCallback> EbmlStatsState::TraceCallback{nullptr};
+void * EbmlStatsState::TraceOpaque = nullptr;
+std::uint32_t EbmlStatsState::TraceId = 0;
+
+void EbmlStatsState::Notify(EbmlTraceEvent Event, const EbmlElement & Element)
+{
+  const auto Callback = TraceCallback.load(std::memory_order_acquire);
+  if (Callback == nullptr)
+    return;
+  if (TraceId != 0 && EbmlId(Element).GetValue() != TraceId)
+    return;
+  Callback(Event, Element, TraceOpaque);
+}
+
+EbmlParserStats EbmlStats::Snapshot()
+{
+  return EbmlStatsState::Counters;
+}
+
+void EbmlStats::Reset()
+{
+  EbmlStatsState::Counters = EbmlParserStats{};
+}
+
+void EbmlStats::SetTraceCallback(EbmlTraceCallback Callback, void * Opaque, std::uint32_t OnlyId)
+{
+  EbmlStatsState::TraceCallback.store(nullptr, std::memory_order_release);
+  EbmlStatsState::TraceOpaque = Opaque;
+  EbmlStatsState::TraceId = OnlyId;
+  EbmlStatsState::TraceCallback.store(Callback, std::memory_order_release);
+}
+
+#else // !EBML_ENABLE_STATS
+
+EbmlParserStats EbmlStats::Snapshot()
+{
+  return {};
+}
+
+void EbmlStats::Reset()
+{
+}
+
+void EbmlStats::SetTraceCallback(EbmlTraceCallback, void *, std::uint32_t)
+{
+}
+
+#endif // !EBML_ENABLE_STATS
+
+} // namespace libebml
@@ -0,0 +1,103 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \author Steve Lhomme     <robux4 @ users.sf.net>
+*/
+#include "ebml/EbmlSubtreeCache.h"
+#include "ebml/EbmlStream.h"
+
+namespace libebml {
+
+EbmlSubtreeCache::EbmlSubtreeCache(IOCallback & aFile, EbmlIndex aIndex, const EbmlSemanticContext & aContext, std::size_t MemoryBudget)
+  :File(aFile)
+  ,Index(std::move(aIndex))
+  ,Context(aContext)
+  ,Budget(MemoryBudget)
+{
+}
+
+static const EbmlCallbacks * FindCallbacks(const EbmlSemanticContext & Context, std::uint32_t Id)
+{
+  const auto & MasterContext = static_cast<const EbmlSemanticContextMaster &>(Context);
+  for (std::size_t i = 0; i < EBML_CTX_SIZE(MasterContext); i++) {
+    if (EBML_CTX_IDX_ID(MasterContext, i).GetValue() == Id)
+      return &EBML_CTX_IDX_INFO(MasterContext, i);
+  }
+  return nullptr;
+}
+
+const EbmlSemanticContext & EbmlSubtreeCache::ParentContext(std::size_t Entry) const
+{
+  const auto Parent = Index[Entry].Parent;
+  if (Parent == EbmlIndex::NoParent)
+    return Context;
+
+  const auto & UpperContext = ParentContext(Parent);
+  const auto * Callbacks = FindCallbacks(UpperContext, Index[Parent].Id);
+  if (Callbacks == nullptr)
+    Callbacks = FindCallbacks(UpperContext.GetGlobalContext(), Index[Parent].Id);
+  if (Callbacks == nullptr)
+    return UpperContext.GetGlobalContext();
+  return Callbacks->GetContext();
+}
+
+std::shared_ptr<EbmlElement> EbmlSubtreeCache::Get(std::size_t Entry)
+{
+  const auto Found = Kept.find(Entry);
+  if (Found != Kept.end()) {
+    Stats.Hits++;
+    Uses.splice(Uses.begin(), Uses, Found->second.Use);
+    return Found->second.Element;
+  }
+
+  Stats.Misses++;
+  std::unique_ptr<EbmlElement> Element(Index.OpenElement(File, Entry, ParentContext(Entry)));
+  if (Element == nullptr)
+    return nullptr;
+
+  EbmlStream Stream(File);
+  int UpperLevel = 0;
+  EbmlElement * UpperElement = nullptr;
+  Element->Read(Stream, EBML_CONTEXT(Element.get()), UpperLevel, UpperElement, true);
+  if (UpperLevel > 0)
+    delete UpperElement;
+
+  const auto Memory = Element->GetMemoryReport().GetTotal().Total();
+  std::shared_ptr<EbmlElement> Result(Element.release());
+  Uses.push_front(Entry);
+  Kept.emplace(Entry, KeptElement{Result, Memory, Uses.begin()});
+  Used += Memory;
+  Evict(Entry);
+  return Result;
+}
+
+void EbmlSubtreeCache::Evict(std::size_t Keep)
+{
+  while (Used > Budget && !Uses.empty()) {
+    const auto Oldest = Uses.back();
+    if (Oldest == Keep)
+      break; // the only element left is larger than the budget
+    const auto Released = Kept.find(Oldest);
+    Used -= Released->second.Memory;
+    Kept.erase(Released);
+    Uses.pop_back();
+    Stats.Evictions++;
+  }
+}
+
+void EbmlSubtreeCache::SetMemoryBudget(std::size_t MemoryBudget)
+{
+  Budget = MemoryBudget;
+  Evict(Uses.empty() ? 0 : Uses.front());
+}
+
+void EbmlSubtreeCache::Clear()
+{
+  Kept.clear();
+  Uses.clear();
+  Used = 0;
+}
+
+} // namespace libebml
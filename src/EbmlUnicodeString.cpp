@@ -14,6 +14,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <utility>
 
 namespace libebml {
 
@@ -77,6 +78,12 @@ void UTFstring::SetUTF8(std::string_view _aStr)
   UTF8string = _aStr.substr(0, lengthToFirstNulll(_aStr));
 }
 
+void UTFstring::SetUTF8(std::string && _aStr)
+{
+  UTF8string = std::move(_aStr);
+  UTF8string.resize(lengthToFirstNulll(UTF8string));
+}
+
 void UTFstring::UpdateFromUCS2(std::wstring_view WString)
 {
   // Only convert up to the first \0 character if present.
@@ -169,10 +176,11 @@ filepos_t EbmlUnicodeString::ReadData(IOCallback & input, ScopeMode ReadFully)
     Value = UTFstring{};
 
   } else {
+    // read in the final storage, short strings don't allocate
     std::string Buffer(static_cast<std::string::size_type>(GetSize()), static_cast<char>(0));
     input.readFully(Buffer.data(), GetSize());
 
-    Value.SetUTF8(Buffer); // SetUTF8 will cut off at the first 0
+    Value.SetUTF8(std::move(Buffer)); // SetUTF8 will cut off at the first 0
   }
 
   SetValueIsSet();
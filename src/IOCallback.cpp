@@ -11,6 +11,7 @@
 #include <limits>
 #include <sstream>
 #include <stdexcept>
+#include <vector>
 
 #include "ebml/IOCallback.h"
 
@@ -54,4 +55,36 @@ void IOCallback::readFully(void*Buffer,std::size_t Size)
   }
 }
 
+std::uint64_t IOCallback::CopyFrom(IOCallback & Source, std::uint64_t Position, std::uint64_t Size)
+{
+  constexpr std::size_t CopyBufferSize = 1024 * 1024;
+  std::vector<binary> Buffer(static_cast<std::size_t>(std::min<std::uint64_t>(Size, CopyBufferSize)));
+
+  const bool SameStream = &Source == this;
+  const auto SourcePosition = Source.getFilePointer();
+  const auto WritePosition = getFilePointer();
+  // copy from the end when the destination overlaps the end of the source
+  const bool Backward = SameStream && WritePosition > Position && WritePosition < Position + Size;
+  std::uint64_t Copied = 0;
+  while (Copied < Size) {
+    const auto Chunk = static_cast<std::size_t>(std::min<std::uint64_t>(Size - Copied, Buffer.size()));
+    const auto Offset = Backward ? Size - Copied - Chunk : Copied;
+    Source.setFilePointer(Position + Offset);
+    if (Source.read(Buffer.data(), Chunk) != Chunk) {
+      stringstream Msg;
+      Msg<<"EOF in CopyFrom("<<Position<<","<<Size<<")";
+      throw runtime_error(Msg.str());
+    }
+    if (SameStream)
+      setFilePointer(WritePosition + Offset);
+    writeFully(Buffer.data(), Chunk);
+    Copied += Chunk;
+  }
+  if (SameStream)
+    setFilePointer(WritePosition + Size);
+  else
+    Source.setFilePointer(SourcePosition);
+  return Copied;
+}
+
 } // namespace libebml
@@ -19,6 +19,13 @@ MemReadIOCallback::MemReadIOCallback(void const *Ptr,
   Init(Ptr, Size);
 }
 
+MemReadIOCallback::MemReadIOCallback(void const *Ptr,
+                                     std::size_t Size,
+                                     std::uint64_t BaseOffset)
+  : mBase(BaseOffset) {
+  Init(Ptr, Size);
+}
+
 MemReadIOCallback::MemReadIOCallback(EbmlBinary const &Binary) {
   Init(Binary.GetBuffer(), Binary.GetSize());
 }
@@ -51,7 +58,7 @@ MemReadIOCallback::read(void *Buffer,
 void
 MemReadIOCallback::setFilePointer(std::int64_t Offset,
                                   seek_mode Mode) {
-  std::int64_t NewPosition = Mode == seek_beginning ? Offset
+  std::int64_t NewPosition = Mode == seek_beginning ? Offset - static_cast<std::int64_t>(mBase)
                     : Mode == seek_end       ? static_cast<std::int64_t>(mEnd - mStart) + Offset
                     :                          static_cast<std::int64_t>(mPtr - mStart) + Offset;
 
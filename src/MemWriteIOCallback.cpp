@@ -0,0 +1,56 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \author Steve Lhomme     <robux4 @ users.sf.net>
+*/
+#include "ebml/MemWriteIOCallback.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace libebml {
+
+MemWriteIOCallback::MemWriteIOCallback(void *Ptr, std::size_t Size, std::uint64_t BaseOffset)
+  :mStart(static_cast<binary *>(Ptr))
+  ,mCapacity(Size)
+  ,mBase(BaseOffset)
+{
+}
+
+std::size_t MemWriteIOCallback::read(void *Buffer, std::size_t Size)
+{
+  const auto Available = GetDataBufferSize();
+  if (mPosition >= Available)
+    return 0;
+  Size = std::min(Size, static_cast<std::size_t>(Available - mPosition));
+  memcpy(Buffer, mStart + mPosition, Size);
+  mPosition += Size;
+  return Size;
+}
+
+void MemWriteIOCallback::setFilePointer(std::int64_t Offset, seek_mode Mode)
+{
+  const std::int64_t NewPosition = Mode == seek_beginning ? Offset - static_cast<std::int64_t>(mBase)
+                                 : Mode == seek_end       ? static_cast<std::int64_t>(mEnd) + Offset
+                                 :                          static_cast<std::int64_t>(mPosition) + Offset;
+  mPosition = static_cast<std::uint64_t>(std::max<std::int64_t>(NewPosition, 0));
+}
+
+std::size_t MemWriteIOCallback::write(const void *Buffer, std::size_t Size)
+{
+  // writing after the end fills the gap with zeros
+  if (mPosition > mEnd && mEnd < mCapacity)
+    memset(mStart + mEnd, 0, static_cast<std::size_t>(std::min<std::uint64_t>(mPosition, mCapacity) - mEnd));
+
+  if (mPosition < mCapacity) {
+    const auto Kept = std::min(Size, static_cast<std::size_t>(mCapacity - mPosition));
+    memcpy(mStart + mPosition, Buffer, Kept);
+  }
+  mPosition += Size;
+  mEnd = std::max(mEnd, mPosition);
+  return Size;
+}
+
+} // namespace libebml
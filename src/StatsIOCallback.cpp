@@ -0,0 +1,91 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \author Steve Lhomme     <robux4 @ users.sf.net>
+*/
+#include "ebml/StatsIOCallback.h"
+
+#include <algorithm>
+
+namespace libebml {
+
+using StatsClock = std::chrono::steady_clock;
+
+std::size_t IOStatistics::SeekBucket(std::uint64_t Distance)
+{
+  std::size_t Bucket = 0;
+  for (Distance >>= 4; Distance != 0 && Bucket < SeekBuckets - 1; Distance >>= 4)
+    Bucket++;
+  return Bucket;
+}
+
+StatsIOCallback::StatsIOCallback(IOCallback & IO)
+  :mIO(IO)
+  ,mPosition(IO.getFilePointer())
+  ,mEnd(mPosition)
+{
+}
+
+std::size_t StatsIOCallback::read(void *Buffer, std::size_t Size)
+{
+  const auto Start = StatsClock::now();
+  const auto Result = mIO.read(Buffer, Size);
+  mStats.ReadTime += StatsClock::now() - Start;
+
+  mStats.Reads++;
+  mStats.BytesRead += Result;
+  if (Result < Size)
+    mStats.ShortReads++;
+  mPosition += Result;
+  mEnd = std::max(mEnd, mPosition);
+  return Result;
+}
+
+std::size_t StatsIOCallback::write(const void *Buffer, std::size_t Size)
+{
+  const auto Start = StatsClock::now();
+  const auto Result = mIO.write(Buffer, Size);
+  mStats.WriteTime += StatsClock::now() - Start;
+
+  mStats.Writes++;
+  mStats.BytesWritten += Result;
+  mPosition += Result;
+  mEnd = std::max(mEnd, mPosition);
+  return Result;
+}
+
+void StatsIOCallback::setFilePointer(std::int64_t Offset, seek_mode Mode)
+{
+  const auto Start = StatsClock::now();
+  mIO.setFilePointer(Offset, Mode);
+  mStats.SeekTime += StatsClock::now() - Start;
+
+  // seeks within the data already read or written land at the requested position,
+  // the wrapped IOCallback may clamp the others
+  const std::int64_t Target = Mode == seek_beginning ? Offset
+                            : Mode == seek_current   ? static_cast<std::int64_t>(mPosition) + Offset
+                            :                          -1;
+  std::uint64_t NewPosition;
+  if (Target >= 0 && static_cast<std::uint64_t>(Target) <= mEnd)
+    NewPosition = static_cast<std::uint64_t>(Target);
+  else {
+    NewPosition = mIO.getFilePointer();
+    mEnd = std::max(mEnd, NewPosition);
+  }
+
+  mStats.Seeks++;
+  if (NewPosition == mPosition) {
+    mStats.NoOpSeeks++;
+  } else {
+    const auto Distance = NewPosition > mPosition ? NewPosition - mPosition : mPosition - NewPosition;
+    if (NewPosition < mPosition)
+      mStats.BackwardSeeks++;
+    mStats.SeekDistance += Distance;
+    mStats.SeekHistogram[IOStatistics::SeekBucket(Distance)]++;
+  }
+  mPosition = NewPosition;
+}
+
+} // namespace libebml
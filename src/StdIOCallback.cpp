@@ -15,6 +15,15 @@
 
 #include "ebml/StdIOCallback.h"
 
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SENDFILE)
+#define HAVE_SYSTEM_COPY
+#include <cerrno>
+#include <unistd.h>
+#endif
+#if defined(HAVE_SENDFILE)
+#include <sys/sendfile.h>
+#endif
+
 using namespace std;
 
 namespace libebml {
@@ -119,6 +128,72 @@ std::uint64_t StdIOCallback::getFilePointer()
   return mCurrentPosition;
 }
 
+std::uint64_t StdIOCallback::CopyFrom(IOCallback & Source, std::uint64_t Position, std::uint64_t Size)
+{
+#if defined(HAVE_SYSTEM_COPY)
+  auto * StdSource = dynamic_cast<StdIOCallback *>(&Source);
+  if (StdSource == nullptr || StdSource == this || StdSource->File == nullptr)
+    return IOCallback::CopyFrom(Source, Position, Size);
+
+  assert(File!=nullptr);
+  // the system copy only sees the data written to the files
+  for (auto * Flushed : { File, StdSource->File }) {
+    if (fflush(Flushed) != 0) {
+      ostringstream Msg;
+      Msg<<"Failed to flush file "<<Flushed;
+      throw ios_base::failure(Msg.str(), error_code{errno, std::system_category()});
+    }
+  }
+
+  const int In = fileno(StdSource->File);
+  const int Out = fileno(File);
+  auto InOffset = static_cast<std::uint64_t>(Position);
+  auto OutOffset = mCurrentPosition;
+  std::uint64_t Copied = 0;
+#if defined(HAVE_COPY_FILE_RANGE)
+  bool UseSendFile = false;
+#else
+  const bool UseSendFile = true;
+#endif
+  while (Copied < Size) {
+    const auto Chunk = static_cast<std::size_t>(std::min<std::uint64_t>(Size - Copied, 1 << 30));
+    ssize_t Done = -1;
+    if (!UseSendFile) {
+#if defined(HAVE_COPY_FILE_RANGE)
+      loff_t CopyIn = static_cast<loff_t>(InOffset);
+      loff_t CopyOut = static_cast<loff_t>(OutOffset);
+      Done = copy_file_range(In, &CopyIn, Out, &CopyOut, Chunk, 0);
+      if (Done < 0 && (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP)) {
+        // not supported between these files
+        UseSendFile = true;
+        continue;
+      }
+#endif
+    } else {
+#if defined(HAVE_SENDFILE)
+      if (lseek(Out, static_cast<off_t>(OutOffset), SEEK_SET) < 0)
+        break;
+      off_t SendIn = static_cast<off_t>(InOffset);
+      Done = sendfile(Out, In, &SendIn, Chunk);
+#endif
+    }
+    if (Done <= 0)
+      break; // end of the source or error, handled by the regular copy
+    InOffset += static_cast<std::uint64_t>(Done);
+    OutOffset += static_cast<std::uint64_t>(Done);
+    Copied += static_cast<std::uint64_t>(Done);
+  }
+
+  // the stdio position is not moved by the system copy
+  setFilePointer(OutOffset);
+  if (Copied < Size)
+    Copied += IOCallback::CopyFrom(Source, Position + Copied, Size - Copied);
+  return Copied;
+#else
+  return IOCallback::CopyFrom(Source, Position, Size);
+#endif
+}
+
 void StdIOCallback::close()
 {
   if(File==nullptr)
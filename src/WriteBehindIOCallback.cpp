@@ -0,0 +1,201 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+/*!
+  \file
+  \author Steve Lhomme     <robux4 @ users.sf.net>
+*/
+#include "ebml/WriteBehindIOCallback.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace libebml {
+
+WriteBehindIOCallback::WriteBehindIOCallback(IOCallback & IO, std::size_t BufferSize, std::size_t BufferCount)
+  :mIO(IO)
+  ,mBufferSize(BufferSize)
+  ,mBufferCount(BufferCount)
+  ,mPosition(IO.getFilePointer())
+{
+  if (BufferSize == 0 || BufferCount == 0)
+    throw std::invalid_argument("write-behind needs at least one buffer");
+
+  mIO.setFilePointer(0, seek_end);
+  mSize = mIO.getFilePointer();
+  mIO.setFilePointer(mPosition);
+  mWriterPosition = mPosition;
+
+  mWriter = std::thread(&WriteBehindIOCallback::WriterThread, this);
+}
+
+WriteBehindIOCallback::~WriteBehindIOCallback()
+{
+  try {
+    Flush();
+  } catch (...) {
+  }
+  {
+    std::lock_guard<std::mutex> Lock(mMutex);
+    mStop = true;
+  }
+  mWork.notify_one();
+  mWriter.join();
+}
+
+void WriteBehindIOCallback::WriterThread()
+{
+  std::unique_lock<std::mutex> Lock(mMutex);
+  for (;;) {
+    mWork.wait(Lock, [this] { return mStop || !mQueue.empty(); });
+    if (mQueue.empty())
+      break;
+    auto Written = std::move(mQueue.front());
+    mQueue.pop_front();
+    mWriting = true;
+    const bool Failed = mError != nullptr;
+    Lock.unlock();
+
+    // after an error the remaining buffers are dropped
+    std::exception_ptr Error;
+    if (!Failed) {
+      try {
+        if (mWriterPosition != Written->Position)
+          mIO.setFilePointer(static_cast<std::int64_t>(Written->Position));
+        mIO.writeFully(Written->Data.get(), Written->Used);
+        mWriterPosition = Written->Position + Written->Used;
+      } catch (...) {
+        Error = std::current_exception();
+      }
+    }
+
+    Lock.lock();
+    if (Error != nullptr)
+      mError = Error;
+    mWriting = false;
+    Written->Used = 0;
+    mFree.push_back(std::move(Written));
+    mDone.notify_all();
+  }
+}
+
+void WriteBehindIOCallback::CheckError()
+{
+  std::lock_guard<std::mutex> Lock(mMutex);
+  if (mError != nullptr) {
+    auto Error = mError;
+    mError = nullptr;
+    std::rethrow_exception(Error);
+  }
+}
+
+std::unique_ptr<WriteBehindIOCallback::Buffer> WriteBehindIOCallback::GetBuffer(std::uint64_t Position)
+{
+  std::unique_ptr<Buffer> Result;
+  {
+    std::unique_lock<std::mutex> Lock(mMutex);
+    if (mFree.empty() && mAllocated >= mBufferCount) {
+      mStalls++;
+      mDone.wait(Lock, [this] { return !mFree.empty(); });
+    }
+    if (!mFree.empty()) {
+      Result = std::move(mFree.back());
+      mFree.pop_back();
+    } else {
+      mAllocated++;
+    }
+  }
+  if (Result == nullptr) {
+    Result = std::make_unique<Buffer>();
+    Result->Data.reset(new binary[mBufferSize]);
+  }
+  Result->Position = Position;
+  return Result;
+}
+
+void WriteBehindIOCallback::Submit()
+{
+  if (mCurrent == nullptr || mCurrent->Used == 0)
+    return;
+  {
+    std::lock_guard<std::mutex> Lock(mMutex);
+    mQueue.push_back(std::move(mCurrent));
+  }
+  mWork.notify_one();
+}
+
+std::size_t WriteBehindIOCallback::write(const void *Buffer, std::size_t Size)
+{
+  CheckError();
+
+  auto Source = static_cast<const binary *>(Buffer);
+  std::size_t Remaining = Size;
+  while (Remaining != 0) {
+    // continue or patch the buffer being filled when possible
+    if (mCurrent == nullptr || mPosition < mCurrent->Position ||
+        mPosition > mCurrent->Position + mCurrent->Used ||
+        mPosition == mCurrent->Position + mBufferSize) {
+      if (mCurrent != nullptr && mCurrent->Used == 0) {
+        mCurrent->Position = mPosition;
+      } else {
+        Submit();
+        mCurrent = GetBuffer(mPosition);
+      }
+    }
+
+    const auto Offset = static_cast<std::size_t>(mPosition - mCurrent->Position);
+    const auto Copied = std::min(Remaining, mBufferSize - Offset);
+    memcpy(mCurrent->Data.get() + Offset, Source, Copied);
+    mCurrent->Used = std::max(mCurrent->Used, Offset + Copied);
+    Source += Copied;
+    Remaining -= Copied;
+    mPosition += Copied;
+  }
+  mSize = std::max(mSize, mPosition);
+  return Size;
+}
+
+void WriteBehindIOCallback::setFilePointer(std::int64_t Offset, seek_mode Mode)
+{
+  switch (Mode) {
+    case seek_beginning:
+      mPosition = Offset;
+      break;
+    case seek_current:
+      mPosition += Offset;
+      break;
+    case seek_end:
+      mPosition = mSize + Offset;
+      break;
+  }
+}
+
+void WriteBehindIOCallback::Flush()
+{
+  Submit();
+  {
+    std::unique_lock<std::mutex> Lock(mMutex);
+    mDone.wait(Lock, [this] { return mQueue.empty() && !mWriting; });
+  }
+  CheckError();
+}
+
+std::size_t WriteBehindIOCallback::read(void *Buffer, std::size_t Size)
+{
+  Flush();
+  // the writer thread is idle until the next write
+  mIO.setFilePointer(static_cast<std::int64_t>(mPosition));
+  const auto Result = mIO.read(Buffer, Size);
+  mPosition += Result;
+  mWriterPosition = mPosition;
+  return Result;
+}
+
+void WriteBehindIOCallback::close()
+{
+  Flush();
+  mIO.close();
+}
+
+} // namespace libebml
@@ -0,0 +1,49 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+// write speed of DirectWriteIOCallback compared to StdIOCallback,
+// not run as a test
+
+#include <ebml/DirectWriteIOCallback.h>
+#include <ebml/StdIOCallback.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace libebml;
+
+static const char Path[] = "bench_direct_write.ebml";
+
+// write the same data through both callbacks
+static double WriteSpeed(IOCallback & Output, const std::vector<binary> & Chunk, std::size_t Count)
+{
+    const auto Start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < Count; i++)
+        Output.writeFully(Chunk.data(), Chunk.size());
+    Output.close();
+    const std::chrono::duration<double> Elapsed = std::chrono::steady_clock::now() - Start;
+    return static_cast<double>(Chunk.size() * Count) / (1024 * 1024) / Elapsed.count();
+}
+
+int main(void)
+{
+    std::vector<binary> Chunk(100 * 1000);
+    for (std::size_t i = 0; i < Chunk.size(); i++)
+        Chunk[i] = static_cast<binary>(i);
+    const std::size_t Count = 160;
+    double StdSpeed, DirectSpeed;
+    {
+        StdIOCallback Std(Path, MODE_CREATE);
+        StdSpeed = WriteSpeed(Std, Chunk, Count);
+    }
+    {
+        DirectWriteIOCallback Direct(Path);
+        DirectSpeed = WriteSpeed(Direct, Chunk, Count);
+    }
+    std::printf("StdIOCallback         %8.1f MiB/s\n", StdSpeed);
+    std::printf("DirectWriteIOCallback %8.1f MiB/s\n", DirectSpeed);
+
+    std::remove(Path);
+    return 0;
+}
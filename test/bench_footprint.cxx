@@ -0,0 +1,50 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+// memory used by each element type when a whole tree is kept in memory,
+// not run as a test
+
+#include <ebml/EbmlHead.h>
+#include <ebml/EbmlBinary.h>
+#include <ebml/EbmlCrc32.h>
+#include <ebml/EbmlDate.h>
+#include <ebml/EbmlFloat.h>
+#include <ebml/EbmlSInteger.h>
+#include <ebml/EbmlString.h>
+#include <ebml/EbmlUInteger.h>
+#include <ebml/EbmlUnicodeString.h>
+#include <ebml/EbmlVoid.h>
+
+#include <cstdio>
+
+using namespace libebml;
+
+#define PRINT_FOOTPRINT(x)  std::printf("%-20s %3zu octets\n", #x, sizeof(x))
+
+int main(void)
+{
+    PRINT_FOOTPRINT(EbmlElement);
+    PRINT_FOOTPRINT(EbmlUInteger);
+    PRINT_FOOTPRINT(EbmlSInteger);
+    PRINT_FOOTPRINT(EbmlFloat);
+    PRINT_FOOTPRINT(EbmlDate);
+    PRINT_FOOTPRINT(EbmlString);
+    PRINT_FOOTPRINT(EbmlUnicodeString);
+    PRINT_FOOTPRINT(EbmlBinary);
+    PRINT_FOOTPRINT(EbmlVoid);
+    PRINT_FOOTPRINT(EbmlCrc32);
+    PRINT_FOOTPRINT(EbmlMaster);
+
+    // a full EBML header, per element with the memory allocated for the values
+    EbmlHead Head;
+    GetChild<EDocType>(Head).SetValue("matroska");
+    GetChild<EDocTypeVersion>(Head).SetValue(4);
+    GetChild<EDocTypeReadVersion>(Head).SetValue(2);
+    const auto Report = Head.GetMemoryReport();
+    for (const auto & Usage : Report.GetPerId())
+        std::printf("%-24s %3zu objects %3zu payload %3zu containers\n", Usage.second.Name,
+                    Usage.second.Objects, Usage.second.Payload, Usage.second.Containers);
+    std::printf("%-24s %3zu octets\n", "total", Report.GetTotal().Total());
+
+    return 0;
+}
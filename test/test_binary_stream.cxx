@@ -0,0 +1,149 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlBinary.h>
+#include <ebml/EbmlContexts.h>
+#include <ebml/EbmlMaster.h>
+#include <ebml/EbmlStream.h>
+#include <ebml/MemIOCallback.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+using namespace libebml;
+
+static constexpr EbmlDocVersion AllVersions{"test_binary_stream"};
+
+DECLARE_xxx_MASTER(TestAttachment,)
+    EBML_CONCRETE_CLASS(TestAttachment)
+};
+DECLARE_xxx_BINARY(TestFileData,)
+    EBML_CONCRETE_CLASS(TestFileData)
+};
+
+DEFINE_xxx_BINARY(TestFileData, 0x465C, TestAttachment, "TestFileData", AllVersions, GetEbmlGlobal_Context)
+
+DEFINE_START_SEMANTIC(TestAttachment)
+DEFINE_SEMANTIC_ITEM(true, true, TestFileData)
+DEFINE_END_SEMANTIC(TestAttachment)
+
+DEFINE_xxx_MASTER_ORPHAN(TestAttachment, 0x61A7, false, "TestAttachment", AllVersions, GetEbmlGlobal_Context)
+
+TestAttachment::TestAttachment()
+  :EbmlMaster(TestAttachment::ClassInfos)
+{}
+
+static binary PayloadAt(std::uint64_t Offset)
+{
+    return static_cast<binary>((Offset * 31) ^ (Offset >> 11));
+}
+
+static constexpr std::uint64_t PayloadSize = 3 * 1024 * 1024 + 17;
+
+// gives the payload in small irregular pieces
+static std::size_t Produce(std::uint64_t Offset, binary * Buffer, std::size_t Size)
+{
+    Size = std::min<std::size_t>(Size, 1000 + Offset % 3000);
+    Size = static_cast<std::size_t>(std::min<std::uint64_t>(Size, PayloadSize - Offset));
+    for (std::size_t i = 0; i < Size; i++)
+        Buffer[i] = PayloadAt(Offset + i);
+    return Size;
+}
+
+static bool CheckPayload(const TestFileData & Data)
+{
+    std::uint64_t Offset = 0;
+    bool Valid = true;
+    Data.ReadChunks([&](const binary * Chunk, std::size_t Size) {
+        if (Size == 0 || Size > EbmlBinary::DefaultChunkSize)
+            Valid = false;
+        for (std::size_t i = 0; i < Size; i++)
+            Valid = Valid && Chunk[i] == PayloadAt(Offset + i);
+        Offset += Size;
+    });
+    return Valid && Offset == PayloadSize;
+}
+
+int main(void)
+{
+    ///// write from a callback
+    MemIOCallback File;
+    {
+        TestAttachment Attachment;
+        auto & Data = GetChild<TestFileData>(Attachment);
+        Data.SetSource(PayloadSize, Produce);
+        if (!Data.IsDeferred() || Data.GetSize() != PayloadSize || Data.GetMemoryReport().GetTotal().Payload != 0)
+            return 1;
+        Attachment.Render(File, EbmlElement::WriteAll);
+        // not loaded by rendering
+        if (!Data.IsDeferred() || !CheckPayload(Data))
+            return 1;
+    }
+    const auto EndOfAttachment = File.getFilePointer();
+
+    ///// read in chunks
+    File.setFilePointer(0);
+    EbmlStream aStream(File);
+    std::unique_ptr<EbmlElement> Found(aStream.FindNextID(EBML_INFO(TestAttachment), 0xFFFFFFFFL));
+    if (Found == nullptr)
+        return 1;
+    int upper = 0;
+    EbmlElement * Upper = nullptr;
+    Found->Read(aStream, EBML_CONTEXT(Found.get()), upper, Upper, false, SCOPE_DEFERRED_DATA);
+    auto & Attachment = static_cast<TestAttachment &>(*Found);
+    const auto & Read = GetChild<const TestFileData>(Attachment);
+    if (!Read.IsDeferred() || Read.GetSize() != PayloadSize)
+        return 1;
+    if (!CheckPayload(Read) || !Read.IsDeferred() || File.getFilePointer() != EndOfAttachment)
+        return 1;
+    const auto DataStart = Read.GetDeferredPosition();
+
+    // smaller chunks
+    std::size_t Chunks = 0;
+    Read.ReadChunks([&Chunks](const binary *, std::size_t) { Chunks++; }, 1024 * 1024);
+    if (Chunks != 4)
+        return 1;
+
+    // the payload was not read
+    File.setFilePointer(Attachment.GetDataStart());
+    std::unique_ptr<EbmlElement> NotRead(aStream.FindNextID(EBML_INFO(TestFileData), 0xFFFFFFFFL));
+    if (NotRead == nullptr)
+        return 1;
+    NotRead->ReadData(File, SCOPE_NO_DATA);
+    try {
+        static_cast<const TestFileData &>(*NotRead).ReadChunks([](const binary *, std::size_t) {});
+        return 1;
+    } catch (const std::runtime_error &) {
+    }
+    File.setFilePointer(EndOfAttachment);
+
+    ///// write from another stream
+    MemIOCallback Output;
+    {
+        TestAttachment Copy;
+        GetChild<TestFileData>(Copy).SetSource(File, DataStart, PayloadSize);
+        Copy.Render(Output, EbmlElement::WriteAll);
+    }
+    if (Output.GetDataBufferSize() != EndOfAttachment || memcmp(Output.GetDataBuffer(), File.GetDataBuffer(), EndOfAttachment) != 0)
+        return 1;
+
+    // a loaded payload is given in chunks too
+    TestFileData Loaded;
+    Loaded.SetSource(PayloadSize, Produce);
+    if (Loaded.GetBuffer() == nullptr || Loaded.IsDeferred() || !CheckPayload(Loaded))
+        return 1;
+
+    ///// the callback doesn't give all the payload
+    TestFileData Truncated;
+    Truncated.SetSource(PayloadSize + 1, Produce);
+    try {
+        MemIOCallback Unused;
+        Truncated.Render(Unused, EbmlElement::WriteAll);
+        return 1;
+    } catch (const std::runtime_error &) {
+    }
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlContexts.h>
+#include <ebml/EbmlMaster.h>
+#include <ebml/EbmlUInteger.h>
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace libebml;
+
+static constexpr EbmlDocVersion AllVersions{"test_bulk"};
+
+DECLARE_xxx_MASTER(TestList,)
+    EBML_CONCRETE_CLASS(TestList)
+};
+DECLARE_xxx_UINTEGER(TestValue,)
+    EBML_CONCRETE_CLASS(TestValue)
+};
+
+DEFINE_xxx_UINTEGER(TestValue, 0xE7, TestList, "TestValue", AllVersions, GetEbmlGlobal_Context)
+
+DEFINE_START_SEMANTIC(TestList)
+DEFINE_SEMANTIC_ITEM(false, false, TestValue)
+DEFINE_END_SEMANTIC(TestList)
+
+DEFINE_xxx_MASTER_ORPHAN(TestList, 0x1F43B675, false, "TestList", AllVersions, GetEbmlGlobal_Context)
+
+TestList::TestList()
+  :EbmlMaster(TestList::ClassInfos)
+{}
+
+static std::uint64_t ValueAt(const EbmlMaster & List, std::size_t Index)
+{
+    return static_cast<const TestValue &>(*List[Index]).GetValue();
+}
+
+static bool IsOdd(const EbmlElement & Element)
+{
+    return static_cast<const TestValue &>(Element).GetValue() % 2 != 0;
+}
+
+static std::vector<std::unique_ptr<EbmlElement>> MakeValues(std::uint64_t First, std::size_t Count)
+{
+    std::vector<std::unique_ptr<EbmlElement>> Result;
+    for (std::size_t i = 0; i < Count; i++) {
+        auto Value = std::make_unique<TestValue>();
+        Value->SetValue(First + i);
+        Result.push_back(std::move(Value));
+    }
+    return Result;
+}
+
+int main(void)
+{
+    ///// insertions
+    TestList List;
+    List.Reserve(1000);
+    List.PushElements(MakeValues(0, 1000));
+    if (List.ListSize() != 1000 || ValueAt(List, 999) != 999)
+        return 1;
+    if (List.InsertElements(MakeValues(5000, 3), 1001))
+        return 1;
+    if (!List.InsertElements(MakeValues(5000, 3), 10) || List.ListSize() != 1003)
+        return 1;
+    if (ValueAt(List, 9) != 9 || ValueAt(List, 10) != 5000 || ValueAt(List, 12) != 5002 || ValueAt(List, 13) != 10)
+        return 1;
+
+    ///// removals keep the order of the other children
+    if (List.RemoveIf([](const EbmlElement & Element) {
+            return static_cast<const TestValue &>(Element).GetValue() >= 5000;
+        }) != 3)
+        return 1;
+    if (List.RemoveIf(IsOdd) != 500 || List.ListSize() != 500)
+        return 1;
+    for (std::size_t i = 0; i < List.ListSize(); i++) {
+        if (ValueAt(List, i) != i * 2)
+            return 1;
+    }
+
+    // a failing predicate leaves the children untouched
+    std::size_t Checked = 0;
+    try {
+        List.RemoveIf([&Checked](const EbmlElement &) {
+            if (++Checked == 100)
+                throw std::runtime_error("predicate failure");
+            return true;
+        });
+        return 1;
+    } catch (const std::runtime_error &) {
+    }
+    if (List.ListSize() != 500)
+        return 1;
+    for (std::size_t i = 0; i < List.ListSize(); i++) {
+        if (ValueAt(List, i) != i * 2)
+            return 1;
+    }
+
+    auto Detached = List.DetachIf([](const EbmlElement & Element) {
+        return static_cast<const TestValue &>(Element).GetValue() % 4 == 0;
+    });
+    if (Detached.size() != 250 || List.ListSize() != 250)
+        return 1;
+    if (static_cast<const TestValue &>(*Detached[1]).GetValue() != 4 || ValueAt(List, 0) != 2)
+        return 1;
+
+    ///// copy-on-write children are not modified
+    List.EnableCopyOnWrite();
+    std::unique_ptr<TestList> Copy(static_cast<TestList *>(List.Clone()));
+    auto CopyDetached = Copy->DetachIf([](const EbmlElement & Element) {
+        return static_cast<const TestValue &>(Element).GetValue() % 8 == 2;
+    });
+    if (CopyDetached.size() != 125 || Copy->ListSize() != 125)
+        return 1;
+    if (CopyDetached[0].get() == static_cast<const TestList &>(List)[0])
+        return 1;
+    static_cast<TestValue &>(*CopyDetached[0]).SetValue(1);
+    if (ValueAt(List, 0) != 2)
+        return 1;
+    if (Copy->RemoveIf([](const EbmlElement &) { return true; }) != 125 || Copy->ListSize() != 0)
+        return 1;
+    if (List.ListSize() != 250)
+        return 1;
+    for (std::size_t i = 0; i < List.ListSize(); i++) {
+        if (ValueAt(List, i) != i * 4 + 2)
+            return 1;
+    }
+
+    // the removed copies no longer reference the template
+    Copy->PushElements(std::move(CopyDetached));
+    List.RemoveAll();
+    List.EnableCopyOnWrite(false);
+    if (Copy->ListSize() != 125 || ValueAt(*Copy, 0) != 1)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlSubtreeCache.h>
+#include <ebml/MemIOCallback.h>
+
+#include <vector>
+
+#include "test_indexed_file.h"
+
+static std::uint64_t ValueOf(const EbmlElement & Info)
+{
+    return static_cast<std::uint64_t>(*FindChild<TestValue>(static_cast<const TestInfo &>(Info)));
+}
+
+int main(void)
+{
+    MemIOCallback File;
+    EbmlHead Head;
+    Head.Render(File);
+
+    static const binary Payload[100] = {};
+    TestSegment Segment;
+    for (unsigned i = 0; i < 6; i++) {
+        auto & Info = AddNewChild<TestInfo>(Segment);
+        GetChild<TestValue>(Info).SetValue(i);
+        GetChild<TestData>(Info).CopyBuffer(Payload, sizeof(Payload));
+    }
+    Segment.Render(File);
+
+    auto Index = EbmlIndex::Build(File, EBML_CLASS_CONTEXT(TestFile), 1);
+    std::vector<std::size_t> Infos;
+    for (auto i = Index.Find(EBML_ID(TestInfo)); i != Index.size(); i = Index.Find(EBML_ID(TestInfo), i + 1))
+        Infos.push_back(i);
+    if (Infos.size() != 6)
+        return 1;
+
+    EbmlSubtreeCache Cache(File, std::move(Index), EBML_CLASS_CONTEXT(TestFile), 0);
+    auto First = Cache.Get(Infos[0]);
+    if (First == nullptr || EbmlId(*First) != EBML_ID(TestInfo) || ValueOf(*First) != 0)
+        return 1;
+    const auto InfoMemory = Cache.GetMemoryUsed();
+    if (InfoMemory < sizeof(Payload) || Cache.GetElementsKept() != 1)
+        return 1;
+
+    // room for 2 subtrees
+    Cache.SetMemoryBudget(InfoMemory * 2 + InfoMemory / 2);
+    for (unsigned i = 1; i < 6; i++) {
+        const auto Info = Cache.Get(Infos[i]);
+        if (Info == nullptr || ValueOf(*Info) != i)
+            return 1;
+    }
+    if (Cache.GetElementsKept() != 2 || Cache.GetMemoryUsed() > Cache.GetMemoryBudget())
+        return 1;
+    if (Cache.GetStatistics().Misses != 6 || Cache.GetStatistics().Hits != 0 || Cache.GetStatistics().Evictions != 4)
+        return 1;
+
+    // released elements are still usable
+    if (ValueOf(*First) != 0)
+        return 1;
+
+    // the last one used is kept
+    if (ValueOf(*Cache.Get(Infos[4])) != 4 || Cache.GetStatistics().Hits != 1)
+        return 1;
+    Cache.Get(Infos[0]);
+    if (Cache.Get(Infos[5]) == nullptr || Cache.GetStatistics().Misses != 8 || Cache.GetStatistics().Evictions != 6)
+        return 1;
+    if (Cache.Get(Infos[0]) == nullptr || Cache.GetStatistics().Hits != 2)
+        return 1;
+
+    // the whole segment, larger than the budget
+    const auto Whole = Cache.Get(Cache.GetIndex().Find(EBML_ID(TestSegment)));
+    if (Whole == nullptr || static_cast<const EbmlMaster &>(*Whole).ListSize() != 6 || Cache.GetElementsKept() != 1)
+        return 1;
+
+    Cache.Clear();
+    if (Cache.GetElementsKept() != 0 || Cache.GetMemoryUsed() != 0)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlHead.h>
+#include <ebml/MemIOCallback.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace libebml;
+
+int main(void)
+{
+    EbmlHead Template;
+    GetChild<EDocType>(Template).SetValue("webm");
+    GetChild<EDocTypeVersion>(Template).SetValue(4);
+    Template.EnableCopyOnWrite();
+
+    std::unique_ptr<EbmlHead> Copy(static_cast<EbmlHead *>(Template.Clone()));
+    if (!Copy->IsCopyOnWrite())
+        return 1;
+    if (Copy->ListSize() != Template.ListSize())
+        return 1;
+
+    // read-only access shares the children
+    const EbmlHead & ConstCopy = *Copy;
+    for (std::size_t i = 0; i < Template.ListSize(); i++) {
+        if (ConstCopy[i] != static_cast<const EbmlHead &>(Template)[i])
+            return 1;
+    }
+
+    // modifying a child of the copy doesn't modify the template
+    const auto * SharedDocType = FindChild<EDocType>(Template);
+    auto & CopyDocType = GetChild<EDocType>(*Copy);
+    if (&CopyDocType == SharedDocType)
+        return 1;
+    CopyDocType.SetValue("matroska");
+    if (static_cast<const std::string &>(*FindChild<EDocType>(Template)) != "webm")
+        return 1;
+    if (FindChild<EDocTypeVersion>(*Copy) != FindChild<EDocTypeVersion>(Template))
+        return 1;
+
+    // removing a shared child releases it without touching the template
+    {
+        std::unique_ptr<EbmlHead> Removed(static_cast<EbmlHead *>(Template.Clone()));
+        const auto Size = Removed->ListSize();
+        Removed->Remove(0);
+        // iterators unshare the children, the caller owns the removed one
+        auto Itr = Removed->begin();
+        std::unique_ptr<EbmlElement> Owned(*Itr);
+        Removed->Remove(Itr);
+        if (Removed->ListSize() != Size - 2 || Template.ListSize() != Size)
+            return 1;
+        if (static_cast<const std::string &>(*FindChild<EDocType>(Template)) != "webm")
+            return 1;
+    }
+
+    // the template can be copied concurrently
+    {
+        std::vector<std::unique_ptr<EbmlHead>> Copies(8);
+        std::vector<std::thread> Threads;
+        for (auto & Copy : Copies)
+            Threads.emplace_back([&Template, &Copy] {
+                Copy.reset(static_cast<EbmlHead *>(Template.Clone()));
+            });
+        for (auto & Thread : Threads)
+            Thread.join();
+        for (const auto & Copy : Copies) {
+            if (Copy->ListSize() != Template.ListSize())
+                return 1;
+        }
+    }
+
+    // the template can be destroyed before its copies
+    std::unique_ptr<EbmlHead> Copy2(static_cast<EbmlHead *>(Template.Clone()));
+    Template.RemoveAll();
+    Template.EnableCopyOnWrite(false);
+
+    MemIOCallback Output;
+    if (Copy2->Render(Output, EbmlElement::WriteAll) != 36)
+        return 1;
+
+    auto Detached = Copy->Detach(*FindChild<EDocTypeVersion>(*Copy));
+    if (!Detached || Detached.get() == FindChild<EDocTypeVersion>(*Copy2))
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,204 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlBinary.h>
+#include <ebml/EbmlContexts.h>
+#include <ebml/EbmlDate.h>
+#include <ebml/EbmlMaster.h>
+#include <ebml/EbmlStream.h>
+#include <ebml/EbmlUInteger.h>
+#include <ebml/MemIOCallback.h>
+#include <ebml/MemReadIOCallback.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace libebml;
+
+static constexpr EbmlDocVersion AllVersions{"test_deferred"};
+
+DECLARE_xxx_MASTER(TestCluster,)
+    EBML_CONCRETE_CLASS(TestCluster)
+};
+DECLARE_xxx_UINTEGER(TestTimestamp,)
+    EBML_CONCRETE_CLASS(TestTimestamp)
+};
+DECLARE_xxx_BINARY(TestBlock,)
+    EBML_CONCRETE_CLASS(TestBlock)
+};
+DECLARE_xxx_DATE(TestDate,)
+    EBML_CONCRETE_CLASS(TestDate)
+};
+
+DEFINE_xxx_UINTEGER(TestTimestamp, 0xE7, TestCluster, "TestTimestamp", AllVersions, GetEbmlGlobal_Context)
+DEFINE_xxx_BINARY(TestBlock, 0xA3, TestCluster, "TestBlock", AllVersions, GetEbmlGlobal_Context)
+DEFINE_xxx_DATE(TestDate, 0x4461, TestCluster, "TestDate", AllVersions, GetEbmlGlobal_Context)
+
+DEFINE_START_SEMANTIC(TestCluster)
+DEFINE_SEMANTIC_ITEM(true, true, TestTimestamp)
+DEFINE_SEMANTIC_ITEM(false, false, TestBlock)
+DEFINE_SEMANTIC_ITEM(false, true, TestDate)
+DEFINE_END_SEMANTIC(TestCluster)
+
+DEFINE_xxx_MASTER_ORPHAN(TestCluster, 0x1F43B675, false, "TestCluster", AllVersions, GetEbmlGlobal_Context)
+
+TestCluster::TestCluster()
+  :EbmlMaster(TestCluster::ClassInfos)
+{}
+
+static std::vector<binary> BlockPayload(std::size_t Index)
+{
+    // the first block is stored inline in the element
+    std::vector<binary> Payload(Index == 0 ? 5 : 1000 + Index);
+    for (std::size_t i = 0; i < Payload.size(); i++)
+        Payload[i] = static_cast<binary>(i + Index);
+    return Payload;
+}
+
+static constexpr std::size_t BlockCount = 4;
+
+int main(void)
+{
+    MemIOCallback File;
+    {
+        TestCluster Cluster;
+        GetChild<TestTimestamp>(Cluster).SetValue(1234);
+        for (std::size_t i = 0; i < BlockCount; i++) {
+            const auto Payload = BlockPayload(i);
+            AddNewChild<TestBlock>(Cluster).CopyBuffer(Payload.data(), static_cast<std::uint32_t>(Payload.size()));
+        }
+        Cluster.Render(File, EbmlElement::WriteAll);
+    }
+    const auto EndOfCluster = File.getFilePointer();
+
+    File.setFilePointer(0);
+    EbmlStream aStream(File);
+    std::unique_ptr<EbmlElement> Found(aStream.FindNextID(EBML_INFO(TestCluster), 0xFFFFFFFFL));
+    if (Found == nullptr)
+        return 1;
+    auto & Cluster = static_cast<TestCluster &>(*Found);
+    int upper = 0;
+    EbmlElement * Upper = nullptr;
+    Cluster.Read(aStream, EBML_CONTEXT(&Cluster), upper, Upper, false, SCOPE_DEFERRED_DATA);
+    if (Upper != nullptr || upper != 0 || File.getFilePointer() != EndOfCluster)
+        return 1;
+
+    // other elements are read
+    if (static_cast<std::uint64_t>(GetChild<const TestTimestamp>(Cluster)) != 1234)
+        return 1;
+
+    std::vector<TestBlock *> Blocks;
+    for (auto Block = FindChild<TestBlock>(Cluster); Block != nullptr; Block = FindNextChild<TestBlock>(Cluster, *Block))
+        Blocks.push_back(Block);
+    if (Blocks.size() != BlockCount)
+        return 1;
+    for (const auto * Block : Blocks) {
+        if (!Block->IsDeferred() || !Block->ValueIsSet() || Block->GetMemoryReport().GetTotal().Payload != 0)
+            return 1;
+    }
+
+    // read in a buffer of the caller without keeping it
+    File.setFilePointer(3);
+    const auto Second = BlockPayload(2);
+    std::vector<binary> Buffer(Blocks[2]->GetSize());
+    Blocks[2]->ReadBuffer(Buffer.data());
+    if (Buffer != Second || !Blocks[2]->IsDeferred() || File.getFilePointer() != 3)
+        return 1;
+
+    // loaded on first access, without moving the stream
+    for (std::size_t i = 0; i < BlockCount; i++) {
+        const auto Payload = BlockPayload(i);
+        const TestBlock & Block = *Blocks[i];
+        const auto * Data = Block.GetBuffer();
+        if (Block.IsDeferred() || Block.GetSize() != Payload.size() || memcmp(Data, Payload.data(), Payload.size()) != 0)
+            return 1;
+        if (Block.GetBuffer() != Data)
+            return 1;
+    }
+    if (File.getFilePointer() != 3)
+        return 1;
+    if (Blocks[1]->GetMemoryReport().GetTotal().Payload != Blocks[1]->GetSize())
+        return 1;
+
+    // a copy of a deferred element compares without loading its payload
+    {
+        File.setFilePointer(0);
+        std::unique_ptr<EbmlElement> Again(aStream.FindNextID(EBML_INFO(TestCluster), 0xFFFFFFFFL));
+        Again->Read(aStream, EBML_CONTEXT(Again.get()), upper, Upper, false, SCOPE_DEFERRED_DATA);
+        auto & Block = *FindChild<TestBlock>(static_cast<TestCluster &>(*Again));
+        std::unique_ptr<EbmlElement> Clone(Block.Clone());
+        const auto & Cloned = static_cast<const TestBlock &>(*Clone);
+        if (!Cloned.IsDeferred() || !(Cloned == *Blocks[0]) || !Cloned.IsDeferred())
+            return 1;
+        // the conversion to the payload loads it
+        if (static_cast<const binary &>(Cloned) != BlockPayload(0)[0] || Cloned.IsDeferred())
+            return 1;
+
+        // a memory reader of a deferred element reads the payload
+        const auto & Second = *FindNextChild<TestBlock>(static_cast<TestCluster &>(*Again), Block);
+        MemReadIOCallback Reader(Second);
+        std::vector<binary> Read(Second.GetSize());
+        if (Reader.read(Read.data(), Read.size()) != Read.size() || Read != BlockPayload(1))
+            return 1;
+
+        // the payload is loaded once by concurrent readers
+        const auto & Third = *FindNextChild<TestBlock>(static_cast<TestCluster &>(*Again), Second);
+        std::vector<const binary *> Buffers(4);
+        std::vector<std::thread> Readers;
+        for (auto & Buffer : Buffers)
+            Readers.emplace_back([&Third, &Buffer] { Buffer = Third.GetBuffer(); });
+        for (auto & Thread : Readers)
+            Thread.join();
+        if (std::count(Buffers.begin(), Buffers.end(), Buffers[0]) != 4 || Third.IsDeferred())
+            return 1;
+        if (memcmp(Buffers[0], BlockPayload(2).data(), Third.GetSize()) != 0)
+            return 1;
+
+        // a deferred element can be rendered
+        MemIOCallback Output;
+        Again->Render(Output, EbmlElement::WriteAll);
+        if (Output.GetDataBufferSize() != EndOfCluster || memcmp(Output.GetDataBuffer(), File.GetDataBuffer(), EndOfCluster) != 0)
+            return 1;
+    }
+
+    // the payload is not available anymore
+    File.setFilePointer(0);
+    std::unique_ptr<EbmlElement> Truncated(aStream.FindNextID(EBML_INFO(TestCluster), 0xFFFFFFFFL));
+    Truncated->Read(aStream, EBML_CONTEXT(Truncated.get()), upper, Upper, false, SCOPE_DEFERRED_DATA);
+    File.SetDataBufferSize(Blocks.back()->GetDataStart() + 1);
+    auto * Last = FindChild<TestBlock>(static_cast<TestCluster &>(*Truncated));
+    while (FindNextChild<TestBlock>(static_cast<TestCluster &>(*Truncated), *Last) != nullptr)
+        Last = FindNextChild<TestBlock>(static_cast<TestCluster &>(*Truncated), *Last);
+    try {
+        Last->GetBuffer();
+        return 1;
+    } catch (const std::runtime_error &) {
+    }
+    if (!Last->IsDeferred())
+        return 1;
+
+    // children that can't be read are dropped like with SCOPE_ALL_DATA
+    {
+        static const binary Broken[] = {
+            0x1F, 0x43, 0xB6, 0x75, 0x85,
+            0x44, 0x61, 0x80, // empty date, without a value
+            0xA3, 0x80,
+        };
+        MemIOCallback BrokenFile;
+        BrokenFile.write(Broken, sizeof(Broken));
+        BrokenFile.setFilePointer(0);
+        EbmlStream BrokenStream(BrokenFile);
+        std::unique_ptr<EbmlElement> BrokenCluster(BrokenStream.FindNextID(EBML_INFO(TestCluster), 0xFFFFFFFFL));
+        if (BrokenCluster == nullptr)
+            return 1;
+        BrokenCluster->Read(BrokenStream, EBML_CONTEXT(BrokenCluster.get()), upper, Upper, false, SCOPE_DEFERRED_DATA);
+        auto & Read = static_cast<TestCluster &>(*BrokenCluster);
+        if (FindChild<TestDate>(Read) != nullptr || FindChild<TestBlock>(Read) == nullptr)
+            return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/DirectWriteIOCallback.h>
+#include <ebml/EbmlHead.h>
+#include <ebml/EbmlVoid.h>
+#include <ebml/MemIOCallback.h>
+#include <ebml/StdIOCallback.h>
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace libebml;
+
+static const char Path[] = "test_direct_write.ebml";
+
+static bool SameFile(const MemIOCallback & Expected)
+{
+    std::vector<binary> Content;
+    {
+        StdIOCallback File(Path, MODE_READ);
+        binary Buffer[4096];
+        for (std::size_t Read; (Read = File.read(Buffer, sizeof(Buffer))) != 0; )
+            Content.insert(Content.end(), Buffer, Buffer + Read);
+    }
+    return Content.size() == Expected.GetDataBufferSize() &&
+           memcmp(Content.data(), Expected.GetDataBuffer(), Content.size()) == 0;
+}
+
+// remove the file written however the test ends
+struct RemoveFile {
+    ~RemoveFile() { std::remove(Path); }
+};
+
+int main(void)
+{
+    const RemoveFile Cleanup;
+
+    ///// random writes, seeks and reads give the same result as a memory file
+    {
+        MemIOCallback Expected;
+        std::mt19937 Random(7);
+        {
+            DirectWriteIOCallback Direct(Path, 2 * DirectWriteIOCallback::Alignment);
+            std::printf("direct I/O: %s\n", Direct.IsDirect() ? "yes" : "no");
+            std::vector<binary> Data(6000);
+            for (unsigned i = 0; i < 1500; i++) {
+                const auto Operation = Random() % 10;
+                if (Operation < 6) {
+                    const auto Size = Random() % Data.size();
+                    for (auto & Byte : Data)
+                        Byte = static_cast<binary>(Random());
+                    Expected.write(Data.data(), Size);
+                    Direct.write(Data.data(), Size);
+                } else if (Operation < 8) {
+                    // patch data written or buffered, like OverwriteHead()
+                    const auto Back = std::min<std::uint64_t>(Random() % 20000, Expected.getFilePointer());
+                    Expected.setFilePointer(-static_cast<std::int64_t>(Back), seek_current);
+                    Direct.setFilePointer(-static_cast<std::int64_t>(Back), seek_current);
+                } else if (Operation < 9) {
+                    Expected.setFilePointer(0, seek_end);
+                    Direct.setFilePointer(0, seek_end);
+                } else {
+                    binary ExpectedRead[5000], DirectRead[5000];
+                    const auto Position = Random() % (Expected.GetDataBufferSize() + 1);
+                    Expected.setFilePointer(Position);
+                    Direct.setFilePointer(Position);
+                    const auto Read = Expected.read(ExpectedRead, sizeof(ExpectedRead));
+                    if (Direct.read(DirectRead, sizeof(DirectRead)) != Read || memcmp(ExpectedRead, DirectRead, Read) != 0)
+                        return 1;
+                }
+                if (Direct.getFilePointer() != Expected.getFilePointer())
+                    return 1;
+                if (i % 500 == 0)
+                    Direct.Flush();
+            }
+        }
+        if (!SameFile(Expected))
+            return 1;
+    }
+
+    ///// element rewrites
+    {
+        MemIOCallback Expected;
+        {
+            DirectWriteIOCallback Direct(Path, DirectWriteIOCallback::Alignment);
+            for (IOCallback * Output : { static_cast<IOCallback *>(&Expected), static_cast<IOCallback *>(&Direct) }) {
+                EbmlVoid Void;
+                Void.SetSize(5000);
+                Void.Render(*Output);
+                EbmlHead Head;
+                GetChild<EDocType>(Head).SetValue("webm");
+                GetChild<EDocTypeVersion>(Head).SetValue(2);
+                Head.Render(*Output);
+                GetChild<EDocTypeVersion>(Head).SetValue(4);
+                Head.OverwriteData(*Output);
+                Head.OverwriteHead(*Output);
+
+                EbmlHead Later;
+                GetChild<EDocType>(Later).SetValue("matroska");
+                Void.ReplaceWith(Later, *Output);
+            }
+            Direct.close();
+            if (!SameFile(Expected))
+                return 1;
+        }
+        // destroying a closed file does nothing
+        if (!SameFile(Expected))
+            return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlHead.h>
+#include <ebml/MemIOCallback.h>
+
+#include <functional>
+#include <stdexcept>
+
+using namespace libebml;
+
+static bool WriteNoDocType(const EbmlElement & elt)
+{
+    return EbmlId(elt) != EBML_ID(EDocType);
+}
+
+static std::uint64_t SizeWith(EbmlMaster & Master, const EbmlElement::ShouldWrite & Filter)
+{
+    Master.UpdateSize(Filter);
+    return Master.ElementSize(Filter);
+}
+
+int main(void)
+{
+    EbmlHead Head;
+    GetChild<EDocTypeVersion>(Head).SetValue(4);
+
+    // built-in filters
+    const auto AllSize = SizeWith(Head, EbmlElement::WriteAll);
+    const auto SkipDefaultSize = SizeWith(Head, EbmlElement::WriteSkipDefault);
+    if (SkipDefaultSize >= AllSize)
+        return 1;
+
+    MemIOCallback AllFile;
+    if (Head.Render(AllFile, EbmlElement::WriteAll) != AllSize)
+        return 1;
+    MemIOCallback SkipDefaultFile;
+    if (Head.Render(SkipDefaultFile) != SkipDefaultSize)
+        return 1;
+
+    // plain function and lambda without capture
+    const auto NoDocTypeSize = SizeWith(Head, WriteNoDocType);
+    if (NoDocTypeSize >= AllSize)
+        return 1;
+    const auto LambdaSize = SizeWith(Head, [](const EbmlElement & elt) { return EbmlId(elt) != EBML_ID(EDocType); });
+    if (LambdaSize != NoDocTypeSize)
+        return 1;
+
+    // callables with a state
+    unsigned Calls = 0;
+    const EbmlElement::ShouldWrite Counting = [&Calls](const EbmlElement &) { Calls++; return true; };
+    MemIOCallback CountingFile;
+    if (Head.Render(CountingFile, Counting) != AllSize || Calls == 0)
+        return 1;
+
+    const std::function<bool(const EbmlElement &)> Function = EbmlElement::WriteAll;
+    if (SizeWith(Head, Function) != AllSize)
+        return 1;
+
+    // no filter function
+    try {
+        const EbmlElement::ShouldWrite::Function NoFunction = nullptr;
+        SizeWith(Head, NoFunction);
+        return 1;
+    } catch (const std::invalid_argument &) {
+    }
+
+    return 0;
+}
@@ -0,0 +1,35 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlHead.h>
+#include <ebml/EbmlBinary.h>
+#include <ebml/EbmlCrc32.h>
+
+using namespace libebml;
+
+// vtable, class info, size, default size, position and the packed flags
+static_assert(sizeof(EbmlElement) <= 4 * sizeof(std::uint64_t) + 2 * sizeof(void *), "EbmlElement is too large");
+
+// the CRC-32 is not part of the master
+static_assert(sizeof(EbmlMaster) < sizeof(EbmlElement) + sizeof(EbmlCrc32), "EbmlMaster embeds its CRC-32");
+
+// the payload pointer, the inline payload and the deferred source
+static_assert(sizeof(EbmlBinary) <= sizeof(EbmlElement) + 2 * sizeof(void *) + EbmlBinary::InlineSize, "EbmlBinary is too large");
+
+int main(void)
+{
+    EbmlHead Head;
+    if (Head.HasChecksum() || Head.GetCrc32() != 0)
+        return 1;
+    Head.ForceChecksum(0x12345678);
+    if (!Head.HasChecksum() || Head.GetCrc32() != 0x12345678)
+        return 1;
+    EbmlHead Copy(Head);
+    if (!Copy.HasChecksum() || Copy.GetCrc32() != 0x12345678)
+        return 1;
+    Head.EnableChecksum(false);
+    if (Head.HasChecksum() || !Copy.HasChecksum())
+        return 1;
+
+    return 0;
+}
@@ -39,6 +39,10 @@ int main(int /*argc*/, char** /*argv*/)
 
     libebml::EbmlHead &ReadHead = static_cast<libebml::EbmlHead &>(*ElementLevel0);
 
+    // masters created for reading don't create their mandatory children
+    if (ReadHead.ListSize() != 0)
+        return 1;
+
     int upper = 0;
     ElementLevel0 = nullptr;
     ReadHead.Read(aStream, EBML_CONTEXT(&ReadHead), upper, ElementLevel0, false);
@@ -51,6 +55,9 @@ int main(int /*argc*/, char** /*argv*/)
     if (!ReadHead.VerifyChecksum())
         return 1;
 
+    if (ReadHead.ListSize() != 7)
+        return 1;
+
     libebml::EDocType & ReadDocType = libebml::GetChild<libebml::EDocType>(ReadHead);
     const std::string & DocTypeStr = static_cast<const std::string &>(ReadDocType);
     if (DocTypeStr != "webm")
@@ -48,5 +48,23 @@ int main(void)
     constexpr EbmlId test4{0x1A45DFA3};
     static_assert(test4.GetLength() == 4, "nope");
 
+    static_assert(test3.GetEncoded()[0] == 0x65 && test3.GetEncoded()[2] == 0x00 && test3.GetEncoded()[3] == 0x00, "nope");
+
+    binary fixed[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+    test2.FillFixed(fixed);
+    if (fixed[0] != 0x58 || fixed[1] != 0x54)
+        return 1;
+
+    // trailing octets after the ID are ignored
+    constexpr binary stream[4] = { 0x58, 0x54, 0x81, 0x42 };
+    if (!test2.Matches(stream))
+        return 1;
+    if (test1.Matches(stream) || test3.Matches(stream))
+        return 1;
+    if (EbmlId(EbmlId::FromEncoded(stream, 2)) != test2)
+        return 1;
+    if (EbmlId(EbmlId::FromEncoded(buf, 4)) != frombuf)
+        return 1;
+
     return 0;
 }
@@ -0,0 +1,192 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlIndex.h>
+#include <ebml/MemIOCallback.h>
+#include <ebml/MemReadIOCallback.h>
+
+#include <memory>
+
+#include "test_indexed_file.h"
+
+static bool SameEntries(const EbmlIndex & A, const EbmlIndex & B)
+{
+    if (A.size() != B.size())
+        return false;
+    for (std::size_t i = 0; i < A.size(); i++) {
+        if (A[i].Position != B[i].Position || A[i].Id != B[i].Id || A[i].Parent != B[i].Parent ||
+            A[i].Depth != B[i].Depth || A[i].DataSize != B[i].DataSize)
+            return false;
+    }
+    return true;
+}
+
+static int TestParallel()
+{
+    MemIOCallback File;
+    EbmlHead Head;
+    Head.Render(File);
+
+    // payloads looking like element heads to trick the resynchronization
+    static const binary Tricky[] = { 0xA1, 0x81, 0x00, 0x15, 0x49, 0xA9, 0x66, 0x82, 0x42, 0x01, 0xA1, 0x85 };
+    TestSegment Segment;
+    for (unsigned i = 0; i < 200; i++) {
+        if (i % 10 == 0)
+            AddNewChild<TestInfo>(Segment);
+        AddNewChild<TestData>(Segment).CopyBuffer(Tricky, (i % sizeof(Tricky)) + 1);
+    }
+    for (auto * Child : Segment) {
+        if (EbmlId(*Child) == EBML_ID(TestInfo))
+            GetChild<TestValue>(static_cast<TestInfo &>(*Child)).SetValue(0xA181);
+    }
+    Segment.Render(File);
+
+    const binary * Buffer = File.GetDataBuffer();
+    const auto BufferSize = File.GetDataBufferSize();
+    const EbmlIndex::FileOpener Opener = [Buffer, BufferSize]() -> std::unique_ptr<IOCallback> {
+        return std::make_unique<MemReadIOCallback>(Buffer, BufferSize);
+    };
+
+    // sequential reference of the Segment children
+    const auto Reference = EbmlIndex::BuildParallel(Opener, EBML_CLASS_CONTEXT(TestSegment), 1, 1,
+                                                    Segment.GetDataStart(), Segment.GetEndPosition());
+    if (Reference.size() != 200 + 20 * 2)
+        return 1;
+    const auto Whole = EbmlIndex::Build(File, EBML_CLASS_CONTEXT(TestFile), 2);
+    const auto FirstChild = Whole.Find(EBML_ID(TestSegment)) + 1;
+    for (std::size_t i = 0; i < Reference.size(); i++) {
+        if (Reference[i].Position != Whole[FirstChild + i].Position || Reference[i].Id != Whole[FirstChild + i].Id)
+            return 1;
+    }
+
+    for (unsigned int Ranges = 2; Ranges <= 16; Ranges++) {
+        const auto Parallel = EbmlIndex::BuildParallel(Opener, EBML_CLASS_CONTEXT(TestSegment), 1, Ranges,
+                                                       Segment.GetDataStart(), Segment.GetEndPosition());
+        if (!SameEntries(Parallel, Reference))
+            return 1;
+    }
+
+    // whole file with the top level context
+    const auto Top = EbmlIndex::BuildParallel(Opener, EBML_CLASS_CONTEXT(TestFile), 2, 4);
+    if (!SameEntries(Top, Whole))
+        return 1;
+
+    return 0;
+}
+
+int main(void)
+{
+    MemIOCallback File;
+    EbmlHead Head;
+    GetChild<EDocType>(Head).SetValue("test_index");
+    Head.Render(File, EbmlElement::WriteAll);
+
+    TestSegment Segment;
+    GetChild<TestValue>(GetChild<TestInfo>(Segment)).SetValue(42);
+    static const binary payload[] = { 0x01, 0x02, 0x03 };
+    for (int i = 0; i < 3; i++)
+        AddNewChild<TestData>(Segment).CopyBuffer(payload, sizeof(payload));
+    Segment.Render(File);
+    const auto SegmentPosition = Segment.GetElementPosition();
+
+    const auto Index = EbmlIndex::Build(File, EBML_CLASS_CONTEXT(TestFile), 1);
+    // the head, its 7 children, the segment, the info and the 3 data
+    if (Index.size() != 13)
+        return 1;
+    const auto SegmentIdx = Index.Find(EBML_ID(TestSegment));
+    if (SegmentIdx == Index.size() || Index[SegmentIdx].Position != SegmentPosition || Index[SegmentIdx].Depth != 0)
+        return 1;
+    if (!Index[SegmentIdx].SizeIsFinite || Index[SegmentIdx].DataSize != Segment.GetSize())
+        return 1;
+    // too deep
+    if (Index.Find(EBML_ID(TestValue)) != Index.size())
+        return 1;
+    std::size_t DataCount = 0;
+    for (auto i = Index.Find(EBML_ID(TestData)); i != Index.size(); i = Index.Find(EBML_ID(TestData), i + 1)) {
+        if (Index[i].Parent != SegmentIdx || Index[i].Depth != 1 || Index[i].DataSize != sizeof(payload))
+            return 1;
+        DataCount++;
+    }
+    if (DataCount != 3)
+        return 1;
+
+    // save and reload the sidecar
+    MemIOCallback Sidecar;
+    Index.Write(Sidecar);
+    if (Sidecar.GetDataBufferSize() != EbmlIndex::HeaderSize + Index.size() * EbmlIndex::EntrySize)
+        return 1;
+    Sidecar.setFilePointer(0);
+    EbmlIndex Reloaded;
+    if (!Reloaded.Read(Sidecar, File) || Reloaded.size() != Index.size())
+        return 1;
+    for (std::size_t i = 0; i < Index.size(); i++) {
+        if (Reloaded[i].Position != Index[i].Position || Reloaded[i].Id != Index[i].Id ||
+            Reloaded[i].Parent != Index[i].Parent || Reloaded[i].HeadSize != Index[i].HeadSize)
+            return 1;
+    }
+
+    // random access in a mapped sidecar
+    EbmlIndexEntry Entry;
+    if (!EbmlIndex::EntryAt(Sidecar.GetDataBuffer(), Sidecar.GetDataBufferSize(), SegmentIdx, Entry))
+        return 1;
+    if (Entry.Position != SegmentPosition || Entry.GetDataStart() != Segment.GetDataStart())
+        return 1;
+    if (EbmlIndex::EntryAt(Sidecar.GetDataBuffer(), Sidecar.GetDataBufferSize(), Index.size(), Entry))
+        return 1;
+
+    // open an element without scanning the file
+    std::unique_ptr<EbmlElement> Opened(Reloaded.OpenElement(File, SegmentIdx, EBML_CLASS_CONTEXT(TestFile)));
+    if (Opened == nullptr || EbmlId(*Opened) != EBML_ID(TestSegment))
+        return 1;
+    if (File.getFilePointer() != Segment.GetDataStart() || Opened->GetSize() != Segment.GetSize())
+        return 1;
+
+    // the file changed, the sidecar is stale
+    File.setFilePointer(0, seek_end);
+    File.write(payload, sizeof(payload));
+    EbmlIndex Stale;
+    if (Index.Matches(File) || Stale.Load(Sidecar.GetDataBuffer(), Sidecar.GetDataBufferSize(), File))
+        return 1;
+
+    // a corrupted entry count doesn't allocate the announced size
+    MemIOCallback Corrupted;
+    Corrupted.write(Sidecar.GetDataBuffer(), EbmlIndex::HeaderSize + EbmlIndex::EntrySize);
+    static const binary HugeCount[] = { 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    Corrupted.setFilePointer(8);
+    Corrupted.write(HugeCount, sizeof(HugeCount));
+    Corrupted.setFilePointer(0);
+    EbmlIndex Invalid;
+    if (Invalid.Read(Corrupted, File))
+        return 1;
+
+    // the scan can't go past an unknown size element that is not scanned
+    {
+        MemIOCallback Live;
+        Head.Render(Live, EbmlElement::WriteAll);
+        // a segment still being written
+        static const binary LiveHead[] = { 0x18, 0x53, 0x80, 0x67, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+        Live.write(LiveHead, sizeof(LiveHead));
+        TestInfo LiveInfo;
+        GetChild<TestValue>(LiveInfo).SetValue(42);
+        LiveInfo.Render(Live);
+        if (Index.IsTruncated())
+            return 1;
+        const auto Partial = EbmlIndex::Build(Live, EBML_CLASS_CONTEXT(TestFile), 0);
+        if (!Partial.IsTruncated() || Partial.size() != 2 || Partial[1].SizeIsFinite)
+            return 1;
+        MemIOCallback PartialSidecar;
+        Partial.Write(PartialSidecar);
+        PartialSidecar.setFilePointer(0);
+        EbmlIndex PartialReloaded;
+        if (!PartialReloaded.Read(PartialSidecar, Live) || !PartialReloaded.IsTruncated())
+            return 1;
+        // scanned as a master
+        if (EbmlIndex::Build(Live, EBML_CLASS_CONTEXT(TestFile), 1).IsTruncated())
+            return 1;
+    }
+
+    if (TestParallel() != 0)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,61 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+// elements of the indexed files used by test_index and test_cache
+#ifndef TEST_INDEXED_FILE_H
+#define TEST_INDEXED_FILE_H
+
+#include <ebml/EbmlHead.h>
+#include <ebml/EbmlBinary.h>
+#include <ebml/EbmlUInteger.h>
+#include <ebml/EbmlContexts.h>
+
+using namespace libebml;
+
+static constexpr EbmlDocVersion AllVersions{"test_indexed_file"};
+
+DECLARE_xxx_MASTER(TestFile,)
+    EBML_CONCRETE_CLASS(TestFile)
+};
+DECLARE_xxx_MASTER(TestSegment,)
+    EBML_CONCRETE_CLASS(TestSegment)
+};
+DECLARE_xxx_MASTER(TestInfo,)
+    EBML_CONCRETE_CLASS(TestInfo)
+};
+DECLARE_xxx_UINTEGER(TestValue,)
+    EBML_CONCRETE_CLASS(TestValue)
+};
+DECLARE_xxx_BINARY(TestData,)
+    EBML_CONCRETE_CLASS(TestData)
+};
+
+DEFINE_xxx_UINTEGER(TestValue, 0x4201, TestInfo, "TestValue", AllVersions, GetEbmlGlobal_Context)
+DEFINE_xxx_BINARY(TestData, 0xA1, TestSegment, "TestData", AllVersions, GetEbmlGlobal_Context)
+
+DEFINE_START_SEMANTIC(TestInfo)
+DEFINE_SEMANTIC_ITEM(true, true, TestValue)
+DEFINE_SEMANTIC_ITEM(false, true, TestData)
+DEFINE_END_SEMANTIC(TestInfo)
+
+DEFINE_xxx_MASTER(TestInfo, 0x1549A966, TestSegment, false, "TestInfo", AllVersions, GetEbmlGlobal_Context)
+
+DEFINE_START_SEMANTIC(TestSegment)
+DEFINE_SEMANTIC_ITEM(false, false, TestInfo)
+DEFINE_SEMANTIC_ITEM(false, false, TestData)
+DEFINE_END_SEMANTIC(TestSegment)
+
+DEFINE_xxx_MASTER(TestSegment, 0x18538067, TestFile, true, "TestSegment", AllVersions, GetEbmlGlobal_Context)
+
+DEFINE_START_SEMANTIC(TestFile)
+DEFINE_SEMANTIC_ITEM(true, true, EbmlHead)
+DEFINE_SEMANTIC_ITEM(true, true, TestSegment)
+DEFINE_END_SEMANTIC(TestFile)
+
+DEFINE_xxx_MASTER_ORPHAN(TestFile, 0x1F000001, false, "TestFile", AllVersions, GetEbmlGlobal_Context)
+
+TestFile::TestFile()
+  :EbmlMaster(TestFile::ClassInfos)
+{}
+
+#endif // TEST_INDEXED_FILE_H
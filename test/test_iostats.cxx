@@ -0,0 +1,96 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlHead.h>
+#include <ebml/EbmlStream.h>
+#include <ebml/MemIOCallback.h>
+#include <ebml/MemReadIOCallback.h>
+#include <ebml/StatsIOCallback.h>
+
+#include <memory>
+
+using namespace libebml;
+
+class PositionCountIOCallback : public MemIOCallback {
+public:
+  std::uint64_t getFilePointer() override {
+    Queries++;
+    return MemIOCallback::getFilePointer();
+  }
+  unsigned Queries = 0;
+};
+
+int main(void)
+{
+    PositionCountIOCallback File;
+    StatsIOCallback Stats(File);
+
+    EbmlHead Head;
+    GetChild<EDocType>(Head).SetValue("webm");
+    const auto HeadSize = Head.Render(Stats, EbmlElement::WriteAll);
+    if (Stats.GetStatistics().BytesWritten != HeadSize || Stats.GetStatistics().Writes == 0)
+        return 1;
+    if (Stats.getFilePointer() != File.getFilePointer())
+        return 1;
+
+    Stats.ResetStatistics();
+    Stats.setFilePointer(0);
+    EbmlStream aStream(Stats);
+    std::unique_ptr<EbmlElement> Found(aStream.FindNextID(EBML_INFO(EbmlHead), 0xFFFFFFFFL));
+    if (Found == nullptr)
+        return 1;
+    int upper = 0;
+    EbmlElement * Child = nullptr;
+    Found->Read(aStream, EBML_CONTEXT(Found.get()), upper, Child, false);
+
+    const auto & Read = Stats.GetStatistics();
+    if (Read.BytesRead != HeadSize || Read.Reads == 0 || Read.Writes != 0)
+        return 1;
+    if (Read.Seeks == 0 || Read.BackwardSeeks != 1 || Read.SeekHistogram[IOStatistics::SeekBucket(HeadSize)] == 0)
+        return 1;
+    if (Stats.getFilePointer() != HeadSize)
+        return 1;
+
+    // seeks don't query the position
+    File.Queries = 0;
+    Stats.setFilePointer(1);
+    Stats.setFilePointer(2, seek_current);
+    if (File.Queries != 0 || Stats.getFilePointer() != 3 || File.getFilePointer() != 3)
+        return 1;
+
+    // seek patterns
+    Stats.setFilePointer(HeadSize);
+    Stats.ResetStatistics();
+    Stats.setFilePointer(0, seek_current);
+    Stats.setFilePointer(-2, seek_end);
+    binary Buffer[8];
+    if (Stats.read(Buffer, sizeof(Buffer)) != 2)
+        return 1;
+    const auto & Seeks = Stats.GetStatistics();
+    if (Seeks.Seeks != 2 || Seeks.NoOpSeeks != 1 || Seeks.BackwardSeeks != 1 || Seeks.SeekDistance != 2)
+        return 1;
+    if (Seeks.ShortReads != 1 || Seeks.SeekHistogram[0] != 1)
+        return 1;
+
+    // seeks clamped by the wrapped IOCallback
+    {
+        static const binary Data[] = { 1, 2, 3, 4 };
+        MemReadIOCallback Memory(Data, sizeof(Data));
+        StatsIOCallback Clamped(Memory);
+        Clamped.setFilePointer(10);
+        if (Clamped.getFilePointer() != Memory.getFilePointer() || Clamped.getFilePointer() != sizeof(Data))
+            return 1;
+        Clamped.setFilePointer(-10, seek_current);
+        if (Clamped.getFilePointer() != 0 || Memory.getFilePointer() != 0)
+            return 1;
+        if (Clamped.GetStatistics().SeekDistance != 2 * sizeof(Data))
+            return 1;
+    }
+
+    if (IOStatistics::SeekBucket(15) != 0 || IOStatistics::SeekBucket(16) != 1 || IOStatistics::SeekBucket(4096) != 3)
+        return 1;
+    if (IOStatistics::SeekBucket(UINT64_MAX) != IOStatistics::SeekBuckets - 1)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlHead.h>
+#include <ebml/MemIOCallback.h>
+#include <ebml/MemWriteIOCallback.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+using namespace libebml;
+
+static std::size_t Allocations = 0;
+
+void * operator new(std::size_t Size)
+{
+    Allocations++;
+    if (void * Result = std::malloc(Size != 0 ? Size : 1))
+        return Result;
+    throw std::bad_alloc();
+}
+
+void operator delete(void * Ptr) noexcept
+{
+    std::free(Ptr);
+}
+
+void operator delete(void * Ptr, std::size_t) noexcept
+{
+    std::free(Ptr);
+}
+
+int main(void)
+{
+    EbmlHead Head;
+    GetChild<EDocType>(Head).SetValue("webm");
+    GetChild<EDocTypeVersion>(Head).SetValue(4);
+    MemIOCallback Expected;
+    Head.Render(Expected);
+
+    ///// rendering in a stack buffer
+    binary Stack[128];
+    MemWriteIOCallback Output(Stack, sizeof(Stack));
+    const auto Before = Allocations;
+    for (int i = 0; i < 100; i++) {
+        Output.Reset();
+        Head.Render(Output);
+    }
+    if (Allocations != Before)
+        return 1;
+    if (Output.IsOverflow() || Output.GetDataBufferSize() != Expected.GetDataBufferSize() ||
+        memcmp(Stack, Expected.GetDataBuffer(), Output.GetDataBufferSize()) != 0)
+        return 1;
+
+    // read back
+    binary Read[4];
+    Output.setFilePointer(0);
+    if (Output.read(Read, sizeof(Read)) != sizeof(Read) || memcmp(Read, Stack, sizeof(Read)) != 0)
+        return 1;
+    Output.setFilePointer(0, seek_end);
+    if (Output.read(Read, sizeof(Read)) != 0)
+        return 1;
+
+    ///// overflow
+    binary Small[10];
+    MemWriteIOCallback Short(Small, sizeof(Small));
+    if (Head.Render(Short) != Expected.GetDataBufferSize())
+        return 1;
+    if (!Short.IsOverflow() || Short.GetRequiredSize() != Expected.GetDataBufferSize() || Short.GetDataBufferSize() != sizeof(Small))
+        return 1;
+    if (memcmp(Small, Expected.GetDataBuffer(), sizeof(Small)) != 0)
+        return 1;
+
+    ///// positions in a larger output
+    GetChild<EDocTypeVersion>(Head).SetValue(2);
+    MemIOCallback Patched;
+    Head.Render(Patched);
+    GetChild<EDocTypeVersion>(Head).SetValue(4);
+
+    MemWriteIOCallback Placed(Stack, sizeof(Stack), 1000);
+    Head.Render(Placed);
+    if (Head.GetElementPosition() != 1000 || Placed.getFilePointer() != 1000 + Expected.GetDataBufferSize())
+        return 1;
+
+    // patch the header
+    GetChild<EDocTypeVersion>(Head).SetValue(2);
+    if (Head.OverwriteData(Placed) == 0 || Head.OverwriteHead(Placed) == 0)
+        return 1;
+    if (Placed.getFilePointer() != 1000 + Expected.GetDataBufferSize() || Placed.GetDataBufferSize() != Patched.GetDataBufferSize())
+        return 1;
+    if (memcmp(Stack, Patched.GetDataBuffer(), Placed.GetDataBufferSize()) != 0)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlHead.h>
+#include <ebml/EbmlContexts.h>
+#include <ebml/EbmlCrc32.h>
+#include <ebml/EbmlVoid.h>
+
+#include <string>
+
+using namespace libebml;
+
+static constexpr EbmlDocVersion AllVersions{"test_memory"};
+
+// a binary element with its own members
+DECLARE_xxx_BINARY(TestLarge,)
+    EBML_CONCRETE_CLASS(TestLarge)
+  private:
+    std::uint64_t Extra[8]{};
+};
+DEFINE_xxx_BINARY(TestLarge, 0x4321, EbmlHead, "TestLarge", AllVersions, GetEbmlGlobal_Context)
+
+int main(void)
+{
+    EbmlHead Head;
+    const std::string LongDocType(100, 'x');
+    GetChild<EDocType>(Head).SetValue(LongDocType);
+
+    static const binary Small[4] = {};
+    static const binary Large[64] = {};
+    auto * SmallVoid = new EbmlVoid;
+    SmallVoid->CopyBuffer(Small, sizeof(Small));
+    Head.PushElement(*SmallVoid);
+    auto * LargeVoid = new EbmlVoid;
+    LargeVoid->CopyBuffer(Large, sizeof(Large));
+    Head.PushElement(*LargeVoid);
+    Head.PushElement(*new TestLarge);
+    Head.EnableChecksum();
+
+    const auto Report = Head.GetMemoryReport();
+    const auto & Total = Report.GetTotal();
+    // the children, the head and its CRC-32
+    if (Total.Elements != Head.ListSize() + 2)
+        return 1;
+    if (Total.Total() != Total.Objects + Total.Payload + Total.Containers)
+        return 1;
+    if (Total.Containers < Head.ListSize() * sizeof(EbmlElement *))
+        return 1;
+
+    const auto & PerId = Report.GetPerId();
+    const auto DocType = PerId.find(EBML_ID(EDocType).GetValue());
+    if (DocType == PerId.end() || DocType->second.Elements != 1 || DocType->second.Payload <= LongDocType.size())
+        return 1;
+    if (std::string(DocType->second.Name) != EBML_INFO(EDocType).GetName())
+        return 1;
+
+    // only the large payload is allocated
+    const auto Voids = PerId.find(EBML_ID(EbmlVoid).GetValue());
+    if (Voids == PerId.end() || Voids->second.Elements != 2 || Voids->second.Payload != sizeof(Large))
+        return 1;
+    if (Voids->second.Objects != 2 * sizeof(EbmlVoid))
+        return 1;
+
+    const auto Crc = PerId.find(EBML_ID(EbmlCrc32).GetValue());
+    if (Crc == PerId.end() || Crc->second.Elements != 1 || Crc->second.Objects != sizeof(EbmlCrc32))
+        return 1;
+
+    // the size of the final class is reported
+    static_assert(sizeof(TestLarge) > sizeof(EbmlBinary), "TestLarge has no extra members");
+    const auto LargeUsage = PerId.find(EBML_ID(TestLarge).GetValue());
+    if (LargeUsage == PerId.end() || LargeUsage->second.Objects != sizeof(TestLarge))
+        return 1;
+
+    const auto Version = PerId.find(EBML_ID(EVersion).GetValue());
+    if (Version == PerId.end() || Version->second.Payload != 0)
+        return 1;
+
+    // the sum of all IDs is the total
+    EbmlMemoryUsage Sum;
+    for (const auto & Usage : PerId) {
+        Sum.Elements += Usage.second.Elements;
+        Sum.Objects += Usage.second.Objects;
+        Sum.Payload += Usage.second.Payload;
+        Sum.Containers += Usage.second.Containers;
+    }
+    if (Sum.Elements != Total.Elements || Sum.Total() != Total.Total())
+        return 1;
+
+    return 0;
+}
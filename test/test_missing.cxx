@@ -2,12 +2,36 @@
 // SPDX-License-Identifier: ISC
 
 #include <ebml/EbmlHead.h>
+#include <ebml/EbmlBinary.h>
+#include <ebml/EbmlContexts.h>
 
 #include <cassert>
+#include <memory>
 #include <string>
 
 using namespace libebml;
 
+static constexpr EbmlDocVersion AllVersions{"test_missing"};
+
+DECLARE_xxx_MASTER(MissingMaster,)
+    EBML_CONCRETE_CLASS(MissingMaster)
+};
+DECLARE_xxx_BINARY(MandatoryData,)
+    EBML_CONCRETE_CLASS(MandatoryData)
+};
+
+DEFINE_xxx_BINARY(MandatoryData, 0x4201, MissingMaster, "MandatoryData", AllVersions, GetEbmlGlobal_Context)
+
+DEFINE_START_SEMANTIC(MissingMaster)
+DEFINE_SEMANTIC_ITEM(true, true, MandatoryData)
+DEFINE_END_SEMANTIC(MissingMaster)
+
+DEFINE_xxx_MASTER_ORPHAN(MissingMaster, 0x1A45DF01, false, "MissingMaster", AllVersions, GetEbmlGlobal_Context)
+
+MissingMaster::MissingMaster()
+  :EbmlMaster(MissingMaster::ClassInfos)
+{}
+
 static void FindAllMissingElements(const EbmlMaster *pThis, std::vector<std::string> & missingElements)
 {
   const auto & MasterContext = pThis->ContextMaster();
@@ -58,5 +82,37 @@ int main(void)
     const auto & tstStatic = EbmlHead::GetContextMaster();
     assert(EBML_CTX_SIZE(tstStatic) != 0);
 
+    // mandatory elements with a default value are never missing
+    if (!TestHead.CheckMandatory())
+        return 1;
+    EbmlMaster::SemanticReport Report;
+    if (!TestHead.CheckSemantic(Report) || !Report.Missing.empty() || !Report.Duplicated.empty())
+        return 1;
+
+    // the same unique element twice
+    AddNewChild<EDocType>(TestHead);
+    AddNewChild<EDocType>(TestHead);
+    if (!TestHead.CheckMandatory())
+        return 1;
+    if (TestHead.CheckSemantic(Report) || Report.Duplicated.size() != 1 || Report.Duplicated[0] != &EBML_INFO(EDocType))
+        return 1;
+    // the previous findings are not kept
+    if (TestHead.CheckSemantic(Report) || Report.Duplicated.size() != 1)
+        return 1;
+
+    // mandatory element without a default value
+    std::unique_ptr<MissingMaster> Missing;
+    {
+        const EbmlMaster::CreateForReading NoMandatory;
+        Missing = std::make_unique<MissingMaster>();
+    }
+    if (Missing->CheckMandatory())
+        return 1;
+    if (Missing->CheckSemantic(Report) || Report.Missing.size() != 1 || Report.Missing[0] != &EBML_INFO(MandatoryData))
+        return 1;
+    GetChild<MandatoryData>(*Missing);
+    if (!Missing->CheckMandatory())
+        return 1;
+
     return 0;
 }
@@ -0,0 +1,120 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlHead.h>
+#include <ebml/EbmlBinary.h>
+#include <ebml/EbmlUnicodeString.h>
+#include <ebml/EbmlContexts.h>
+
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+using namespace libebml;
+
+// the children of a master can't be moved in a master of another class
+static_assert(!std::is_move_assignable<EbmlMaster>::value, "EbmlMaster is move assignable");
+static_assert(std::is_move_assignable<EbmlHead>::value, "EbmlHead is not move assignable");
+
+static constexpr EbmlDocVersion AllVersions{"test_move"};
+
+DECLARE_xxx_BINARY(BinaryClass,)
+    EBML_CONCRETE_CLASS(BinaryClass)
+};
+DEFINE_xxx_BINARY(BinaryClass, 0x4321, EbmlHead, "BinaryClass", AllVersions, GetEbmlGlobal_Context)
+
+DECLARE_xxx_UNISTRING(UniStringClass,)
+    EBML_CONCRETE_CLASS(UniStringClass)
+};
+DEFINE_xxx_UNISTRING(UniStringClass, 0x4123, EbmlHead, "UniStringClass", AllVersions, GetEbmlGlobal_Context)
+
+int main(void)
+{
+    static const binary payload[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20 };
+    static const binary smallPayload[] = { 1, 2, 3, 4, 5 };
+    static_assert(sizeof(payload) > EbmlBinary::InlineSize, "large payload expected");
+
+    BinaryClass bin;
+    bin.CopyBuffer(payload, sizeof(payload));
+    const binary *buffer = bin.GetBuffer();
+
+    BinaryClass movedBin(std::move(bin));
+    if (movedBin.GetBuffer() != buffer || movedBin.GetSize() != sizeof(payload) || !movedBin.ValueIsSet())
+        return 1;
+    if (bin.GetBuffer() != nullptr || bin.GetSize() != 0)
+        return 1;
+
+    BinaryClass assignedBin;
+    assignedBin = std::move(movedBin);
+    if (assignedBin.GetBuffer() != buffer || assignedBin.GetSize() != sizeof(payload))
+        return 1;
+    if (movedBin.GetBuffer() != nullptr)
+        return 1;
+
+    // small payloads live inside the element and are copied on move
+    BinaryClass smallBin;
+    smallBin.CopyBuffer(smallPayload, sizeof(smallPayload));
+    BinaryClass movedSmallBin(std::move(smallBin));
+    if (movedSmallBin.GetSize() != sizeof(smallPayload) || memcmp(movedSmallBin.GetBuffer(), smallPayload, sizeof(smallPayload)) != 0)
+        return 1;
+    if (smallBin.GetBuffer() != nullptr || smallBin.GetSize() != 0)
+        return 1;
+    BinaryClass copiedSmallBin(movedSmallBin);
+    if (copiedSmallBin.GetBuffer() == movedSmallBin.GetBuffer() || !(copiedSmallBin == movedSmallBin))
+        return 1;
+    assignedBin = std::move(copiedSmallBin);
+    if (assignedBin.GetSize() != sizeof(smallPayload) || memcmp(assignedBin.GetBuffer(), smallPayload, sizeof(smallPayload)) != 0)
+        return 1;
+
+    EDocType docType;
+    docType.SetValue("webm");
+    EDocType movedDocType(std::move(docType));
+    if (static_cast<const std::string &>(movedDocType) != "webm")
+        return 1;
+
+    UniStringClass uni;
+    uni.SetValueUTF8("unicode");
+    UniStringClass movedUni(std::move(uni));
+    if (movedUni.GetValueUTF8() != "unicode")
+        return 1;
+
+    EbmlHead head;
+    GetChild<EDocType>(head).SetValue("webm");
+    const auto children = head.ListSize();
+    auto * firstChild = head[0];
+
+    EbmlHead movedHead(std::move(head));
+    if (movedHead.ListSize() != children || movedHead[0] != firstChild)
+        return 1;
+    if (head.ListSize() != 0)
+        return 1;
+
+    EbmlHead assignedHead;
+    assignedHead = std::move(movedHead);
+    if (assignedHead.ListSize() != children || assignedHead[0] != firstChild)
+        return 1;
+
+    auto & readDocType = GetChild<EDocType>(assignedHead);
+    auto detached = DetachChild(assignedHead, readDocType);
+    if (!detached || detached.get() != &readDocType)
+        return 1;
+    if (assignedHead.ListSize() != children - 1)
+        return 1;
+    if (FindChild<EDocType>(assignedHead) != nullptr)
+        return 1;
+    if (assignedHead.Detach(*detached))
+        return 1;
+
+    if (!assignedHead.PushElement(std::move(detached)))
+        return 1;
+    if (FindChild<EDocType>(assignedHead) != &readDocType)
+        return 1;
+
+    auto all = assignedHead.DetachAll();
+    if (all.size() != children || assignedHead.ListSize() != 0)
+        return 1;
+    if (assignedHead.Detach(0))
+        return 1;
+
+    return 0;
+}
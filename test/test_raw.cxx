@@ -0,0 +1,172 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlContexts.h>
+#include <ebml/EbmlHead.h>
+#include <ebml/EbmlRawElement.h>
+#include <ebml/EbmlVoid.h>
+#include <ebml/MemIOCallback.h>
+#include <ebml/StdIOCallback.h>
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace libebml;
+
+static constexpr EbmlDocVersion AllVersions{"test_raw"};
+
+DEFINE_START_SEMANTIC(TestStream)
+DEFINE_SEMANTIC_ITEM(false, false, EbmlVoid)
+DEFINE_END_SEMANTIC(TestStream)
+
+DECLARE_xxx_MASTER(TestStream,)
+EBML_CONCRETE_CLASS(TestStream)
+};
+
+DEFINE_EBML_MASTER_ORPHAN(TestStream, 0x1F43B675, true, "TestStream", AllVersions)
+
+TestStream::TestStream()
+    :EbmlMaster(TestStream::ClassInfos)
+{}
+
+// a large void element followed by an EBML header
+static void WriteSource(IOCallback & Output, const std::vector<binary> & Payload)
+{
+    EbmlVoid Void;
+    Void.CopyBuffer(Payload.data(), static_cast<std::uint32_t>(Payload.size()));
+    Void.Render(Output, EbmlElement::WriteAll);
+    EbmlHead Head;
+    GetChild<EDocType>(Head).SetValue("webm");
+    Head.Render(Output, EbmlElement::WriteAll);
+}
+
+static std::unique_ptr<EbmlElement> FindVoid(IOCallback & Source)
+{
+    Source.setFilePointer(0);
+    return std::unique_ptr<EbmlElement>(EbmlElement::FindNextID(Source, EBML_INFO(EbmlVoid), 0xFFFFFFFFFFL));
+}
+
+static std::vector<binary> ReadAll(const char * Path)
+{
+    std::vector<binary> Result;
+    StdIOCallback File(Path, MODE_READ);
+    binary Buffer[4096];
+    for (std::size_t Read; (Read = File.read(Buffer, sizeof(Buffer))) != 0; )
+        Result.insert(Result.end(), Buffer, Buffer + Read);
+    return Result;
+}
+
+int main(void)
+{
+    std::vector<binary> Payload(2500 * 1024);
+    for (std::size_t i = 0; i < Payload.size(); i++)
+        Payload[i] = static_cast<binary>(i * 7);
+
+    ///// memory streams
+    MemIOCallback Source;
+    WriteSource(Source, Payload);
+    const auto Void = FindVoid(Source);
+    if (Void == nullptr)
+        return 1;
+    const auto VoidEnd = Void->GetEndPosition();
+
+    EbmlRawElement Raw(Source, *Void);
+    if (EbmlId(Raw) != EBML_ID(EbmlVoid) || Raw.GetSize() != Payload.size() || Raw.GetSourcePosition() != Void->GetDataStart())
+        return 1;
+
+    Source.setFilePointer(VoidEnd);
+    MemIOCallback Output;
+    static const binary Prefix[] = { 0x42 };
+    Output.write(Prefix, sizeof(Prefix));
+    if (Raw.Render(Output) != VoidEnd)
+        return 1;
+    // the source position is kept
+    if (Source.getFilePointer() != VoidEnd)
+        return 1;
+    if (Output.GetDataBufferSize() != sizeof(Prefix) + VoidEnd ||
+        memcmp(Output.GetDataBuffer() + sizeof(Prefix), Source.GetDataBuffer(), VoidEnd) != 0)
+        return 1;
+    if (Raw.GetElementPosition() != sizeof(Prefix))
+        return 1;
+
+    // copy within the same stream
+    Source.setFilePointer(0, seek_end);
+    const auto CopyStart = Source.getFilePointer();
+    Raw.Render(Source);
+    if (memcmp(Source.GetDataBuffer() + CopyStart, Source.GetDataBuffer(), VoidEnd) != 0)
+        return 1;
+
+    // overlapping copies within the same stream
+    for (const std::int64_t Shift : { 1000, -1000 }) {
+        MemIOCallback Overlap;
+        Overlap.write(Payload.data(), Payload.size());
+        const std::uint64_t From = Shift > 0 ? 0 : 1000;
+        const std::uint64_t Size = Payload.size() - 1000;
+        Overlap.setFilePointer(From + Shift);
+        if (Overlap.CopyFrom(Overlap, From, Size) != Size || Overlap.getFilePointer() != From + Shift + Size)
+            return 1;
+        if (memcmp(Overlap.GetDataBuffer() + From + Shift, Payload.data() + From, Size) != 0)
+            return 1;
+    }
+
+    // an unknown size element can't be copied
+    TestStream Stream;
+    Stream.SetSizeInfinite();
+    try {
+        EbmlRawElement Unknown(Source, Stream);
+        return 1;
+    } catch (const std::invalid_argument &) {
+    }
+
+    ///// files
+    static const char SourcePath[] = "test_raw_source.ebml";
+    static const char OutputPath[] = "test_raw_output.ebml";
+    {
+        StdIOCallback SourceFile(SourcePath, MODE_CREATE);
+        WriteSource(SourceFile, Payload);
+    }
+    {
+        StdIOCallback SourceFile(SourcePath, MODE_READ);
+        const auto FileVoid = FindVoid(SourceFile);
+        if (FileVoid == nullptr)
+            return 1;
+        EbmlRawElement FileRaw(SourceFile, *FileVoid);
+
+        StdIOCallback OutputFile(OutputPath, MODE_CREATE);
+        OutputFile.write(Prefix, sizeof(Prefix));
+        if (FileRaw.Render(OutputFile) != VoidEnd || OutputFile.getFilePointer() != sizeof(Prefix) + VoidEnd)
+            return 1;
+        // stdio writes after the system copy
+        OutputFile.write(Prefix, sizeof(Prefix));
+    }
+    const auto Copied = ReadAll(OutputPath);
+    const auto Original = ReadAll(SourcePath);
+    if (Copied.size() != VoidEnd + 2 * sizeof(Prefix) || Copied.front() != Prefix[0] || Copied.back() != Prefix[0])
+        return 1;
+    if (memcmp(Copied.data() + sizeof(Prefix), Original.data(), VoidEnd) != 0)
+        return 1;
+
+    // data still buffered in the source file are copied
+    {
+        StdIOCallback SourceFile(SourcePath, MODE_CREATE);
+        static const binary Written[] = { 9, 9, 9, 9, 9, 9, 9, 9 };
+        SourceFile.write(Written, sizeof(Written));
+        // seeking writes the data to the file
+        SourceFile.setFilePointer(0);
+        static const binary Buffered[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+        SourceFile.write(Buffered, sizeof(Buffered));
+        StdIOCallback OutputFile(OutputPath, MODE_CREATE);
+        if (OutputFile.CopyFrom(SourceFile, 2, 4) != 4)
+            return 1;
+        OutputFile.close();
+        const auto Result = ReadAll(OutputPath);
+        if (Result.size() != 4 || memcmp(Result.data(), Buffered + 2, 4) != 0)
+            return 1;
+    }
+    std::remove(SourcePath);
+    std::remove(OutputPath);
+
+    return 0;
+}
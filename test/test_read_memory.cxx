@@ -0,0 +1,98 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlHead.h>
+#include <ebml/EbmlStream.h>
+#include <ebml/MemIOCallback.h>
+#include <ebml/MemReadIOCallback.h>
+
+#include <memory>
+
+using namespace libebml;
+
+class CountingIOCallback : public MemIOCallback {
+public:
+  std::size_t read(void *Buffer, std::size_t Size) override {
+    Reads++;
+    return MemIOCallback::read(Buffer, Size);
+  }
+  unsigned Reads = 0;
+};
+
+static std::unique_ptr<EbmlHead> ReadHead(CountingIOCallback & File, std::uint64_t Start, std::uint64_t Threshold = 0)
+{
+    File.setFilePointer(Start);
+    EbmlStream aStream(File);
+    aStream.SetReadInMemoryThreshold(Threshold);
+    std::unique_ptr<EbmlHead> Head(static_cast<EbmlHead *>(aStream.FindNextID(EBML_INFO(EbmlHead), 0xFFFFFFFFL)));
+    if (Head == nullptr)
+        return nullptr;
+    File.Reads = 0;
+
+    int upper = 0;
+    EbmlElement * Found = nullptr;
+    Head->Read(aStream, EBML_CONTEXT(Head.get()), upper, Found, false);
+    if (Found != nullptr || upper != 0)
+        return nullptr;
+    return Head;
+}
+
+int main(void)
+{
+    CountingIOCallback File;
+    // the head is not at the start of the file
+    static const binary Junk[] = { 0x12, 0x34 };
+    File.write(Junk, sizeof(Junk));
+    EbmlHead Head;
+    GetChild<EDocType>(Head).SetValue("webm");
+    GetChild<EDocTypeVersion>(Head).SetValue(4);
+    Head.Render(File, EbmlElement::WriteAll);
+    const auto EndOfHead = File.getFilePointer();
+
+    const auto Regular = ReadHead(File, sizeof(Junk));
+    if (Regular == nullptr || File.getFilePointer() != EndOfHead)
+        return 1;
+    const auto RegularReads = File.Reads;
+
+    const auto InMemory = ReadHead(File, sizeof(Junk), 1024);
+    if (InMemory == nullptr || File.getFilePointer() != EndOfHead)
+        return 1;
+    if (File.Reads != 1 || File.Reads >= RegularReads)
+        return 1;
+
+    // same children at the same positions in the file
+    if (InMemory->ListSize() != Regular->ListSize())
+        return 1;
+    for (std::size_t i = 0; i < Regular->ListSize(); i++) {
+        const auto & A = *(*Regular)[i];
+        const auto & B = *(*InMemory)[i];
+        if (EbmlId(A) != EbmlId(B) || A.GetElementPosition() != B.GetElementPosition() || A.GetSize() != B.GetSize())
+            return 1;
+    }
+    if (static_cast<const std::string &>(GetChild<const EDocType>(*InMemory)) != "webm")
+        return 1;
+    if (static_cast<std::uint64_t>(GetChild<const EDocTypeVersion>(*InMemory)) != 4)
+        return 1;
+
+    // a copy of a memory reader starts at the current data, at position 0
+    static const binary Data[] = { 1, 2, 3, 4, 5, 6 };
+    MemReadIOCallback Memory(Data, sizeof(Data), 100);
+    Memory.setFilePointer(102);
+    MemReadIOCallback Copy(Memory);
+    if (Copy.getFilePointer() != 0 || Copy.GetDataBufferSize() != 4)
+        return 1;
+    Copy.setFilePointer(2);
+    binary Read;
+    if (Copy.read(&Read, 1) != 1 || Read != 5)
+        return 1;
+
+    // the file positions are kept with the base offset
+    MemReadIOCallback Based(Memory.GetDataBuffer(), sizeof(Data) - 2, Memory.getFilePointer());
+    if (Based.getFilePointer() != 102)
+        return 1;
+    Based.setFilePointer(104);
+    if (Based.read(&Read, 1) != 1 || Read != 5)
+        return 1;
+
+    return 0;
+}
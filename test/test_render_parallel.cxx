@@ -0,0 +1,165 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlBinary.h>
+#include <ebml/EbmlContexts.h>
+#include <ebml/EbmlMaster.h>
+#include <ebml/EbmlUInteger.h>
+#include <ebml/MemIOCallback.h>
+
+#include <cstring>
+#include <vector>
+
+using namespace libebml;
+
+static constexpr EbmlDocVersion AllVersions{"test_render_parallel"};
+
+DECLARE_xxx_MASTER(TestSegment,)
+    EBML_CONCRETE_CLASS(TestSegment)
+};
+DECLARE_xxx_MASTER(TestCluster,)
+    EBML_CONCRETE_CLASS(TestCluster)
+};
+DECLARE_xxx_UINTEGER(TestTimestamp,)
+    EBML_CONCRETE_CLASS(TestTimestamp)
+};
+DECLARE_xxx_BINARY(TestBlock,)
+    EBML_CONCRETE_CLASS(TestBlock)
+};
+
+DEFINE_xxx_UINTEGER(TestTimestamp, 0xE7, TestCluster, "TestTimestamp", AllVersions, GetEbmlGlobal_Context)
+DEFINE_xxx_BINARY(TestBlock, 0xA3, TestCluster, "TestBlock", AllVersions, GetEbmlGlobal_Context)
+
+DEFINE_START_SEMANTIC(TestCluster)
+DEFINE_SEMANTIC_ITEM(true, true, TestTimestamp)
+DEFINE_SEMANTIC_ITEM(false, false, TestBlock)
+DEFINE_END_SEMANTIC(TestCluster)
+
+DEFINE_xxx_MASTER(TestCluster, 0x1F43B675, TestSegment, false, "TestCluster", AllVersions, GetEbmlGlobal_Context)
+
+DEFINE_START_SEMANTIC(TestSegment)
+DEFINE_SEMANTIC_ITEM(false, false, TestCluster)
+DEFINE_END_SEMANTIC(TestSegment)
+
+DEFINE_xxx_MASTER_ORPHAN(TestSegment, 0x18538067, true, "TestSegment", AllVersions, GetEbmlGlobal_Context)
+
+TestSegment::TestSegment()
+  :EbmlMaster(TestSegment::ClassInfos)
+{}
+
+static void FillSegment(TestSegment & Segment)
+{
+    for (unsigned c = 0; c < 24; c++) {
+        auto & Cluster = AddNewChild<TestCluster>(Segment);
+        GetChild<TestTimestamp>(Cluster).SetValue(c * 1000);
+        if (c % 5 == 0)
+            Cluster.EnableChecksum();
+        for (unsigned b = 0; b < 3 + c % 4; b++) {
+            std::vector<binary> Payload(100 + c * 37 + b * 1000);
+            for (std::size_t i = 0; i < Payload.size(); i++)
+                Payload[i] = static_cast<binary>(i ^ (c << 3) ^ b);
+            AddNewChild<TestBlock>(Cluster).CopyBuffer(Payload.data(), static_cast<std::uint32_t>(Payload.size()));
+        }
+    }
+}
+
+static void Positions(const EbmlMaster & Master, std::vector<std::uint64_t> & Result)
+{
+    Result.push_back(Master.GetElementPosition());
+    for (const auto * Element : Master) {
+        if (Element->IsMaster())
+            Positions(static_cast<const EbmlMaster &>(*Element), Result);
+        else
+            Result.push_back(Element->GetElementPosition());
+    }
+}
+
+static bool Compare(bool WithChecksum, const EbmlElement::ShouldWrite & Filter)
+{
+    static const binary Prefix[] = { 0x12, 0x34, 0x56 };
+
+    TestSegment Sequential;
+    FillSegment(Sequential);
+    Sequential.EnableChecksum(WithChecksum);
+    MemIOCallback SequentialOutput;
+    SequentialOutput.write(Prefix, sizeof(Prefix));
+    const auto SequentialSize = Sequential.Render(SequentialOutput, Filter);
+
+    TestSegment Parallel;
+    FillSegment(Parallel);
+    Parallel.EnableChecksum(WithChecksum);
+    MemIOCallback ParallelOutput;
+    ParallelOutput.write(Prefix, sizeof(Prefix));
+    const auto ParallelSize = Parallel.RenderParallel(ParallelOutput, 4, Filter);
+
+    if (ParallelSize != SequentialSize || ParallelOutput.getFilePointer() != SequentialOutput.getFilePointer())
+        return false;
+    if (ParallelOutput.GetDataBufferSize() != SequentialOutput.GetDataBufferSize() ||
+        memcmp(ParallelOutput.GetDataBuffer(), SequentialOutput.GetDataBuffer(), SequentialOutput.GetDataBufferSize()) != 0)
+        return false;
+
+    // rendering again gives the same output and CRC-32
+    MemIOCallback AgainOutput;
+    AgainOutput.write(Prefix, sizeof(Prefix));
+    Parallel.RenderParallel(AgainOutput, 4, Filter);
+    if (AgainOutput.GetDataBufferSize() != SequentialOutput.GetDataBufferSize() ||
+        memcmp(AgainOutput.GetDataBuffer(), SequentialOutput.GetDataBuffer(), SequentialOutput.GetDataBufferSize()) != 0)
+        return false;
+
+    std::vector<std::uint64_t> SequentialPositions, ParallelPositions;
+    Positions(Sequential, SequentialPositions);
+    Positions(Parallel, ParallelPositions);
+    return SequentialPositions == ParallelPositions && WithChecksum == Parallel.HasChecksum() &&
+           (!WithChecksum || Parallel.GetCrc32() == Sequential.GetCrc32());
+}
+
+int main(void)
+{
+    if (!Compare(false, EbmlElement::WriteSkipDefault))
+        return 1;
+    if (!Compare(true, EbmlElement::WriteSkipDefault))
+        return 1;
+    if (!Compare(false, EbmlElement::WriteAll))
+        return 1;
+
+    // a single thread renders like Render()
+    TestSegment Segment;
+    FillSegment(Segment);
+    MemIOCallback Output;
+    if (Segment.RenderParallel(Output, 1) != Output.GetDataBufferSize())
+        return 1;
+
+    // an unknown size is rendered like Render()
+    TestSegment Live;
+    FillSegment(Live);
+    Live.SetSizeInfinite();
+    MemIOCallback LiveSequential;
+    Live.Render(LiveSequential);
+    MemIOCallback LiveParallel;
+    Live.RenderParallel(LiveParallel, 4);
+    if (LiveParallel.GetDataBufferSize() != LiveSequential.GetDataBufferSize() ||
+        memcmp(LiveParallel.GetDataBuffer(), LiveSequential.GetDataBuffer(), LiveSequential.GetDataBufferSize()) != 0)
+        return 1;
+
+    // blocks read from the same stream are rendered like Render()
+    MemIOCallback Source;
+    std::vector<binary> Payload(5000);
+    for (std::size_t i = 0; i < Payload.size(); i++)
+        Payload[i] = static_cast<binary>(i * 7);
+    Source.write(Payload.data(), Payload.size());
+    TestSegment Deferred;
+    for (unsigned c = 0; c < 8; c++) {
+        auto & Cluster = AddNewChild<TestCluster>(Deferred);
+        GetChild<TestTimestamp>(Cluster).SetValue(c);
+        AddNewChild<TestBlock>(Cluster).SetSource(Source, c * 500, 1000);
+    }
+    MemIOCallback DeferredParallel;
+    Deferred.RenderParallel(DeferredParallel, 4);
+    MemIOCallback DeferredSequential;
+    Deferred.Render(DeferredSequential);
+    if (DeferredParallel.GetDataBufferSize() != DeferredSequential.GetDataBufferSize() ||
+        memcmp(DeferredParallel.GetDataBuffer(), DeferredSequential.GetDataBuffer(), DeferredSequential.GetDataBufferSize()) != 0)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlHeadSchema.h>
+#include <ebml/EbmlSchema.h>
+#include <ebml/EbmlStream.h>
+#include <ebml/EbmlVoid.h>
+#include <ebml/EbmlContexts.h>
+#include <ebml/MemIOCallback.h>
+
+#include <cstring>
+#include <memory>
+
+using namespace libebml;
+
+static constexpr EbmlDocVersion AllVersions{"test_schema"};
+
+DECLARE_xxx_MASTER(TestMaster,)
+    EBML_CONCRETE_CLASS(TestMaster)
+};
+DECLARE_xxx_SINTEGER(TestSigned,)
+    EBML_CONCRETE_CLASS(TestSigned)
+};
+DECLARE_xxx_FLOAT(TestFloat,)
+    EBML_CONCRETE_CLASS(TestFloat)
+};
+DECLARE_xxx_DATE(TestDate,)
+    EBML_CONCRETE_CLASS(TestDate)
+};
+DECLARE_xxx_UNISTRING(TestTitle,)
+    EBML_CONCRETE_CLASS(TestTitle)
+};
+DECLARE_xxx_BINARY(TestData,)
+    EBML_CONCRETE_CLASS(TestData)
+};
+DECLARE_xxx_UINTEGER_DEF(TestFlag,)
+    EBML_CONCRETE_CLASS(TestFlag)
+};
+
+DEFINE_xxx_SINTEGER(TestSigned, 0x4201, TestMaster, "TestSigned", AllVersions, GetEbmlGlobal_Context)
+DEFINE_xxx_FLOAT(TestFloat, 0x4202, TestMaster, "TestFloat", AllVersions, GetEbmlGlobal_Context)
+DEFINE_xxx_DATE(TestDate, 0x4203, TestMaster, "TestDate", AllVersions, GetEbmlGlobal_Context)
+DEFINE_xxx_UNISTRING(TestTitle, 0x4204, TestMaster, "TestTitle", AllVersions, GetEbmlGlobal_Context)
+DEFINE_xxx_BINARY(TestData, 0x4205, TestMaster, "TestData", AllVersions, GetEbmlGlobal_Context)
+DEFINE_xxx_UINTEGER_DEF(TestFlag, 0x4206, TestMaster, "TestFlag", AllVersions, GetEbmlGlobal_Context, 1)
+
+DEFINE_START_SEMANTIC(TestMaster)
+DEFINE_SEMANTIC_ITEM(false, true, TestSigned)
+DEFINE_SEMANTIC_ITEM(false, true, TestFloat)
+DEFINE_SEMANTIC_ITEM(false, true, TestDate)
+DEFINE_SEMANTIC_ITEM(false, true, TestTitle)
+DEFINE_SEMANTIC_ITEM(false, true, TestData)
+DEFINE_SEMANTIC_ITEM(true, true, TestFlag)
+DEFINE_END_SEMANTIC(TestMaster)
+
+DEFINE_xxx_MASTER_ORPHAN(TestMaster, 0x1A45DF00, false, "TestMaster", AllVersions, GetEbmlGlobal_Context)
+
+TestMaster::TestMaster()
+  :EbmlMaster(TestMaster::ClassInfos)
+{}
+
+struct TestValues {
+    std::int64_t Signed;
+    double Float;
+    std::int64_t Date;
+    UTFstring Title;
+    std::vector<binary> Data;
+    std::uint32_t Flag;
+};
+
+using TestSchema = EbmlSchema<TestMaster, TestValues,
+    EbmlSchemaField<&TestValues::Signed, TestSigned>,
+    EbmlSchemaField<&TestValues::Float,  TestFloat>,
+    EbmlSchemaField<&TestValues::Date,   TestDate>,
+    EbmlSchemaField<&TestValues::Title,  TestTitle>,
+    EbmlSchemaField<&TestValues::Data,   TestData>,
+    EbmlSchemaField<&TestValues::Flag,   TestFlag>>;
+
+int main(void)
+{
+    ///// EBML header read without creating its children
+    MemIOCallback HeadFile;
+    EbmlHead Head;
+    GetChild<EDocType>(Head).SetValue("webm");
+    GetChild<EDocTypeVersion>(Head).SetValue(4);
+    GetChild<EMaxSizeLength>(Head).SetValue(7);
+    Head.Render(HeadFile, EbmlElement::WriteAll);
+
+    HeadFile.setFilePointer(0);
+    EbmlStream aStream(HeadFile);
+    std::unique_ptr<EbmlElement> Found(aStream.FindNextID(EBML_INFO(EbmlHead), 0xFFFFFFFFL));
+    if (Found == nullptr)
+        return 1;
+
+    EbmlHeadValues HeadValues;
+    if (!EbmlHeadSchema::Read(HeadFile, *Found, HeadValues))
+        return 1;
+    if (HeadValues.DocType != "webm" || HeadValues.DocTypeVersion != 4 || HeadValues.MaxSizeLength != 7)
+        return 1;
+    if (HeadValues.Version != 1 || HeadValues.MaxIdLength != 4)
+        return 1;
+    if (HeadFile.getFilePointer() != HeadFile.GetDataBufferSize())
+        return 1;
+
+    // an unknown size master cannot be decoded at once
+    Found->SetSizeInfinite();
+    HeadFile.setFilePointer(0);
+    if (EbmlHeadSchema::Read(HeadFile, *Found, HeadValues))
+        return 1;
+
+    ///// user schema with all the element types
+    TestMaster Master;
+    GetChild<TestSigned>(Master).SetValue(-300);
+    GetChild<TestFloat>(Master).SetValue(0.5);
+    GetChild<TestDate>(Master).SetValue(1700000000);
+    GetChild<TestTitle>(Master).SetValueUTF8("title");
+    static const binary payload[] = { 0xDE, 0xAD, 0xBE, 0xEF };
+    GetChild<TestData>(Master).CopyBuffer(payload, sizeof(payload));
+    auto & Void = AddNewChild<EbmlVoid>(Master);
+    Void.SetSize(3);
+
+    MemIOCallback MasterFile;
+    Master.Render(MasterFile, EbmlElement::WriteSkipDefault);
+
+    // skip the master head
+    const binary * Buffer = MasterFile.GetDataBuffer();
+    const auto HeadSize = Master.GetDataStart();
+    TestValues Values;
+    if (!TestSchema::Decode(Buffer + HeadSize, MasterFile.GetDataBufferSize() - HeadSize, Values))
+        return 1;
+    if (Values.Signed != -300 || Values.Float != 0.5 || Values.Date != 1700000000)
+        return 1;
+    if (Values.Title.GetUTF8() != "title")
+        return 1;
+    if (Values.Data.size() != sizeof(payload) || memcmp(Values.Data.data(), payload, sizeof(payload)) != 0)
+        return 1;
+    if (Values.Flag != 1) // default value, not written
+        return 1;
+
+    // truncated payload
+    if (TestSchema::Decode(Buffer + HeadSize, MasterFile.GetDataBufferSize() - HeadSize - 1, Values))
+        return 1;
+
+    // an empty float is 0.0
+    static const binary EmptyFloat[] = { 0x42, 0x02, 0x80 };
+    Values.Float = 0.5;
+    if (!TestSchema::Decode(EmptyFloat, sizeof(EmptyFloat), Values) || Values.Float != 0.0)
+        return 1;
+
+    return 0;
+}
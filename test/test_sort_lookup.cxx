@@ -0,0 +1,126 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlContexts.h>
+#include <ebml/EbmlMaster.h>
+#include <ebml/EbmlUInteger.h>
+
+#include <algorithm>
+#include <random>
+
+using namespace libebml;
+
+static constexpr EbmlDocVersion AllVersions{"test_sort_lookup"};
+
+DECLARE_xxx_MASTER(TestIndex,)
+    EBML_CONCRETE_CLASS(TestIndex)
+};
+DECLARE_xxx_MASTER(TestPoint,)
+    EBML_CONCRETE_CLASS(TestPoint)
+};
+DECLARE_xxx_UINTEGER(TestTime,)
+    EBML_CONCRETE_CLASS(TestTime)
+};
+DECLARE_xxx_UINTEGER(TestPosition,)
+    EBML_CONCRETE_CLASS(TestPosition)
+};
+
+DEFINE_xxx_UINTEGER(TestTime, 0xB3, TestPoint, "TestTime", AllVersions, GetEbmlGlobal_Context)
+DEFINE_xxx_UINTEGER(TestPosition, 0xF1, TestPoint, "TestPosition", AllVersions, GetEbmlGlobal_Context)
+
+DEFINE_START_SEMANTIC(TestPoint)
+DEFINE_SEMANTIC_ITEM(false, true, TestTime)
+DEFINE_SEMANTIC_ITEM(false, true, TestPosition)
+DEFINE_END_SEMANTIC(TestPoint)
+
+DEFINE_xxx_MASTER(TestPoint, 0xBB, TestIndex, false, "TestPoint", AllVersions, GetEbmlGlobal_Context)
+
+DEFINE_START_SEMANTIC(TestIndex)
+DEFINE_SEMANTIC_ITEM(false, false, TestPoint)
+DEFINE_END_SEMANTIC(TestIndex)
+
+DEFINE_xxx_MASTER_ORPHAN(TestIndex, 0x1C53BB6B, false, "TestIndex", AllVersions, GetEbmlGlobal_Context)
+
+TestIndex::TestIndex()
+  :EbmlMaster(TestIndex::ClassInfos)
+{}
+
+static std::uint64_t TimeAt(const EbmlMaster & Index, std::size_t i)
+{
+    return FindChild<TestTime>(static_cast<const TestPoint &>(*Index[i]))->GetValue();
+}
+
+static std::uint64_t PositionAt(const EbmlMaster & Index, std::size_t i)
+{
+    return FindChild<TestPosition>(static_cast<const TestPoint &>(*Index[i]))->GetValue();
+}
+
+int main(void)
+{
+    ///// a large index sorted by the value of a child
+    TestIndex Index;
+    std::mt19937 Random(3);
+    const std::size_t Count = 20000;
+    for (std::size_t i = 0; i < Count; i++) {
+        auto & Point = AddNewChild<TestPoint>(Index);
+        // 2 points per time, in the order of their position
+        GetChild<TestTime>(Point).SetValue((Random() % (Count / 2)) * 10);
+        GetChild<TestPosition>(Point).SetValue(i);
+    }
+    // a point without time
+    AddNewChild<TestPoint>(Index);
+
+    SortByChild<TestTime>(Index);
+    if (FindChild<TestTime>(static_cast<const TestPoint &>(*Index[Count])) != nullptr)
+        return 1;
+    for (std::size_t i = 1; i < Count; i++) {
+        if (TimeAt(Index, i - 1) > TimeAt(Index, i))
+            return 1;
+        // equal keys keep their order
+        if (TimeAt(Index, i - 1) == TimeAt(Index, i) && PositionAt(Index, i - 1) > PositionAt(Index, i))
+            return 1;
+    }
+
+    ///// lookups give the same result as a linear scan
+    std::size_t Lower = 0;
+    for (std::uint64_t Time = 0; Time < Count * 5 + 20; Time += 7) {
+        while (Lower < Count && TimeAt(Index, Lower) < Time)
+            Lower++;
+        std::size_t Upper = Lower;
+        while (Upper < Count && TimeAt(Index, Upper) <= Time)
+            Upper++;
+        if (LowerBoundChild<TestTime>(Index, Time) != Lower)
+            return 1;
+        if (UpperBoundChild<TestTime>(Index, Time) != Upper)
+            return 1;
+    }
+
+    ///// custom keys
+    const auto ByPosition = [](const EbmlElement & Point) {
+        return FindChild<TestPosition>(static_cast<const TestPoint &>(Point))->GetValue();
+    };
+    Index.RemoveIf([](const EbmlElement & Point) {
+        return FindChild<TestTime>(static_cast<const TestPoint &>(Point)) == nullptr;
+    });
+    Index.SortBy(ByPosition);
+    for (std::size_t i = 0; i < Count; i++) {
+        if (PositionAt(Index, i) != i)
+            return 1;
+    }
+    if (Index.LowerBound(std::uint64_t{1234}, ByPosition) != 1234 || Index.UpperBound(std::uint64_t{Count}, ByPosition) != Count)
+        return 1;
+
+    ///// same order as Sort() on values
+    TestPoint Values;
+    for (std::size_t i = 0; i < 1000; i++)
+        static_cast<TestTime &>(*Values.AddNewElt(EBML_INFO(TestTime))).SetValue(Random() % 100);
+    TestPoint Sorted(Values);
+    Values.Sort();
+    Sorted.SortBy([](const EbmlElement & Time) { return static_cast<const TestTime &>(Time).GetValue(); });
+    for (std::size_t i = 0; i < Values.ListSize(); i++) {
+        if (static_cast<const TestTime &>(*Values[i]).GetValue() != static_cast<const TestTime &>(*Sorted[i]).GetValue())
+            return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlHead.h>
+#include <ebml/EbmlDummy.h>
+#include <ebml/EbmlStats.h>
+#include <ebml/EbmlStream.h>
+#include <ebml/EbmlContexts.h>
+#include <ebml/MemIOCallback.h>
+
+#include <memory>
+
+using namespace libebml;
+
+struct TraceCounts {
+    unsigned ReadBegin = 0;
+    unsigned ReadEnd = 0;
+    unsigned RenderBegin = 0;
+    unsigned RenderEnd = 0;
+};
+
+static void CountTrace(EbmlTraceEvent Event, const EbmlElement &, void * Opaque)
+{
+    auto & Counts = *static_cast<TraceCounts *>(Opaque);
+    switch (Event) {
+        case EbmlTraceEvent::ReadBegin:   Counts.ReadBegin++;   break;
+        case EbmlTraceEvent::ReadEnd:     Counts.ReadEnd++;     break;
+        case EbmlTraceEvent::RenderBegin: Counts.RenderBegin++; break;
+        case EbmlTraceEvent::RenderEnd:   Counts.RenderEnd++;   break;
+    }
+}
+
+int main(void)
+{
+    MemIOCallback File;
+    // junk before the head
+    static const binary Junk[] = { 0x00, 0x00 };
+    File.write(Junk, sizeof(Junk));
+    EbmlHead Head;
+    GetChild<EDocType>(Head).SetValue("webm");
+    auto * Unknown = new EbmlDummy(EbmlId(0x4321));
+    Unknown->CopyBuffer(Junk, sizeof(Junk));
+    Head.PushElement(*Unknown);
+    Head.Render(File, EbmlElement::WriteAll);
+    const auto Children = Head.ListSize();
+
+    EbmlStats::Reset();
+    TraceCounts Counts;
+    EbmlStats::SetTraceCallback(CountTrace, &Counts);
+
+    File.setFilePointer(0);
+    EbmlStream aStream(File);
+    int upper = 0;
+    std::unique_ptr<EbmlElement> Found(aStream.FindNextElement(Context_EbmlHead, upper, 0xFFFFFFFFL, false));
+    if (Found == nullptr || EbmlId(*Found) != EBML_ID(EbmlHead))
+        return 1;
+    EbmlElement * Child = nullptr;
+    upper = 0;
+    Found->Read(aStream, EBML_CONTEXT(Found.get()), upper, Child, true);
+    if (static_cast<EbmlMaster &>(*Found).ListSize() != Children)
+        return 1;
+
+    const auto Stats = EbmlStats::Snapshot();
+    if (EbmlStats::Enabled) {
+        if (Stats.ResyncBytes != sizeof(Junk) || Stats.DummyElements != 1 || Stats.GlobalContextLookups == 0)
+            return 1;
+        if (Stats.ElementsCreated != Children || Stats.ElementsDeleted != 0)
+            return 1;
+        if (Counts.ReadBegin != Children + 1 || Counts.ReadEnd != Counts.ReadBegin)
+            return 1;
+    } else {
+        if (Stats.ResyncBytes != 0 || Stats.ElementsCreated != 0 || Counts.ReadBegin != 0)
+            return 1;
+    }
+
+    // only trace the DocType
+    TraceCounts DocTypeCounts;
+    EbmlStats::SetTraceCallback(CountTrace, &DocTypeCounts, EBML_ID(EDocType).GetValue());
+    MemIOCallback Output;
+    Head.Render(Output, EbmlElement::WriteAll);
+    EbmlStats::SetTraceCallback(nullptr);
+    if (DocTypeCounts.RenderBegin != (EbmlStats::Enabled ? 1 : 0) || DocTypeCounts.RenderEnd != DocTypeCounts.RenderBegin)
+        return 1;
+
+    EbmlStats::Reset();
+    if (EbmlStats::Snapshot().ResyncBytes != 0)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+// Copyright © 2024 Steve Lhomme.
+// SPDX-License-Identifier: ISC
+
+#include <ebml/EbmlHead.h>
+#include <ebml/EbmlVoid.h>
+#include <ebml/MemIOCallback.h>
+#include <ebml/WriteBehindIOCallback.h>
+
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace libebml;
+
+// a slow file, to fill the buffers faster than they are written
+class SlowIOCallback : public MemIOCallback {
+public:
+  std::size_t write(const void *Buffer, std::size_t Size) override {
+    if (FailWrites)
+      throw std::runtime_error("disk full");
+    std::this_thread::yield();
+    return MemIOCallback::write(Buffer, Size);
+  }
+  bool FailWrites = false;
+};
+
+static bool SameContent(const MemIOCallback & A, const MemIOCallback & B)
+{
+  return A.GetDataBufferSize() == B.GetDataBufferSize() &&
+         memcmp(A.GetDataBuffer(), B.GetDataBuffer(), A.GetDataBufferSize()) == 0;
+}
+
+int main(void)
+{
+    ///// random writes, seeks and reads give the same result as direct writes
+    {
+        MemIOCallback Direct;
+        SlowIOCallback File;
+        std::mt19937 Random(42);
+        {
+            WriteBehindIOCallback Behind(File, 64, 2);
+            std::vector<binary> Data(300);
+            for (unsigned i = 0; i < 2000; i++) {
+                const auto Operation = Random() % 10;
+                if (Operation < 6) {
+                    const auto Size = Random() % Data.size();
+                    for (auto & Byte : Data)
+                        Byte = static_cast<binary>(Random());
+                    Direct.write(Data.data(), Size);
+                    Behind.write(Data.data(), Size);
+                } else if (Operation < 8) {
+                    // patch before the current position, like OverwriteHead()
+                    const auto Back = std::min<std::uint64_t>(Random() % 200, Direct.getFilePointer());
+                    Direct.setFilePointer(-static_cast<std::int64_t>(Back), seek_current);
+                    Behind.setFilePointer(-static_cast<std::int64_t>(Back), seek_current);
+                } else if (Operation < 9) {
+                    Direct.setFilePointer(0, seek_end);
+                    Behind.setFilePointer(0, seek_end);
+                } else {
+                    binary DirectRead[16], BehindRead[16];
+                    const auto Position = Random() % (Direct.GetDataBufferSize() + 1);
+                    Direct.setFilePointer(Position);
+                    Behind.setFilePointer(Position);
+                    const auto Read = Direct.read(DirectRead, sizeof(DirectRead));
+                    if (Behind.read(BehindRead, sizeof(BehindRead)) != Read || memcmp(DirectRead, BehindRead, Read) != 0)
+                        return 1;
+                }
+                if (Behind.getFilePointer() != Direct.getFilePointer())
+                    return 1;
+            }
+            Behind.Flush();
+            if (!SameContent(Direct, File))
+                return 1;
+            // the buffers were all in use at some point
+            if (Behind.GetStalls() == 0)
+                return 1;
+        }
+    }
+
+    ///// element rewrites
+    {
+        MemIOCallback Direct;
+        SlowIOCallback File;
+        {
+            WriteBehindIOCallback Behind(File, 32, 3);
+            for (IOCallback * Output : { static_cast<IOCallback *>(&Direct), static_cast<IOCallback *>(&Behind) }) {
+                EbmlVoid Void;
+                Void.SetSize(100);
+                Void.Render(*Output);
+                EbmlHead Head;
+                GetChild<EDocType>(Head).SetValue("webm");
+                GetChild<EDocTypeVersion>(Head).SetValue(2);
+                Head.Render(*Output);
+                // a larger value with the same size, like updating a position
+                GetChild<EDocTypeVersion>(Head).SetValue(4);
+                Head.OverwriteData(*Output);
+                Head.OverwriteHead(*Output);
+
+                EbmlHead Later;
+                GetChild<EDocType>(Later).SetValue("matroska");
+                Void.ReplaceWith(Later, *Output);
+            }
+            Behind.close();
+        }
+        if (!SameContent(Direct, File))
+            return 1;
+    }
+
+    ///// write errors are reported
+    {
+        SlowIOCallback File;
+        WriteBehindIOCallback Behind(File, 16, 2);
+        File.FailWrites = true;
+        static const binary Data[40] = {};
+        try {
+            Behind.write(Data, sizeof(Data));
+            Behind.Flush();
+            return 1;
+        } catch (const std::runtime_error &) {
+        }
+        // reported once
+        Behind.Flush();
+    }
+
+    return 0;
+}